@@ -19,10 +19,23 @@
   3. This notice may not be removed or altered from any source distribution.
 -------------------------------------------------------------------------------
 */
+#include <atomic>
+#include <unordered_map>
 #include "TestDirectory.h"
+#include "Utils/Char.h"
 #include "Utils/FileSystem.h"
+#include "Xml/Binary.h"
+#include "Xml/Diff.h"
 #include "Xml/File.h"
+#include "Xml/Query.h"
 #include "Xml/Scanner.h"
+#include "Xml/Schema.h"
+#include "Xml/Writer.h"
+#include "Xml/SharedNode.h"
+#include "Xml/Snapshot.h"
+#include "Xml/SpecialChar.h"
+#include "Xml/StreamWriter.h"
+#include "Xml/ViewFile.h"
 #include "gtest/gtest.h"
 #include "Utils/TextStreamWriter.h"
 
@@ -152,3 +165,1229 @@ GTEST_TEST(Xml, NodeParseStructure)
     expected << "---_text_node" << std::endl;
     EXPECT_EQ(expected.str(), oss.str());
 }
+
+GTEST_TEST(Xml, ConstructClone)
+{
+    StringStream ss;
+    ss << "<root a='1'><foo b='2'>A<b>B</b>C</foo><bar/></root>";
+
+    File parser;
+    parser.read(ss);
+
+    const Node* root = parser.root("root");
+    EXPECT_NE(nullptr, root);
+
+    Node*       clone = File::constructClone(root, nullptr, 0);
+    const Node* copy  = clone->firstChild();
+    EXPECT_NE(nullptr, copy);
+    EXPECT_NE(root, copy);
+    EXPECT_EQ(copy->name(), "root");
+    EXPECT_EQ(copy->attribute("a"), "1");
+    EXPECT_EQ(copy->size(), 2u);
+
+    const Node* foo = copy->firstChildOf("foo");
+    EXPECT_NE(nullptr, foo);
+    EXPECT_EQ(foo->attribute("b"), "2");
+    EXPECT_EQ(foo->text(), "C");
+    EXPECT_EQ(foo->size(), 3u);
+    EXPECT_EQ(foo->at(0)->text(), "A");
+    EXPECT_EQ(foo->at(1)->text(), "B");
+    EXPECT_EQ(foo->at(2)->text(), "C");
+
+    constexpr TypeFilter filter[] = {
+        {"root", 1},
+        { "foo", 2},
+        {   "b", 3},
+    };
+    delete clone;
+
+    clone = File::constructClone(root, filter, 3);
+    copy  = clone->firstChild();
+    EXPECT_NE(nullptr, copy);
+    EXPECT_EQ(copy->type(), 1);
+    EXPECT_EQ(copy->size(), 1u);
+    EXPECT_EQ(copy->at(0)->type(), 2);
+    EXPECT_EQ(copy->at(0)->size(), 1u);
+    EXPECT_EQ(copy->at(0)->at(0)->type(), 3);
+    EXPECT_FALSE(copy->at(0)->at(0)->hasChildren());
+    delete clone;
+}
+
+GTEST_TEST(Xml, SharedNode_PathCopy)
+{
+    StringStream ss;
+    ss << "<root><a x='1'><b/><c/></a><d><e/></d></root>";
+
+    File parser;
+    parser.read(ss);
+
+    const SharedNodePtr v0 = SharedNode::fromNode(parser.root("root"));
+    EXPECT_EQ(v0->name(), "root");
+    EXPECT_EQ(v0->size(), 2u);
+
+    const SharedNodePtr v1 = SharedNode::setAttribute(v0, {0, 1}, "y", "2");
+    EXPECT_NE(v0, v1);
+
+    // only the path root -> a -> c was copied
+    EXPECT_NE(v0->at(0), v1->at(0));
+    EXPECT_NE(v0->at(0)->at(1), v1->at(0)->at(1));
+    EXPECT_EQ(v0->at(0)->at(0), v1->at(0)->at(0));
+    EXPECT_EQ(v0->at(1), v1->at(1));
+
+    EXPECT_FALSE(v0->at(0)->at(1)->contains("y"));
+    EXPECT_EQ(v1->at(0)->at(1)->attribute("y"), "2");
+    EXPECT_EQ(v1->at(0)->attribute("x"), "1");
+
+    const SharedNodePtr v2 = SharedNode::removeChild(v1, {1}, 0);
+    EXPECT_EQ(v1->at(1)->size(), 1u);
+    EXPECT_EQ(v2->at(1)->size(), 0u);
+    EXPECT_EQ(v1->at(0), v2->at(0));
+
+    const SharedNodePtr v3 = SharedNode::insertChild(v2, {}, 1, std::make_shared<SharedNode>("f"));
+    EXPECT_EQ(v3->size(), 3u);
+    EXPECT_EQ(v3->at(1)->name(), "f");
+    EXPECT_EQ(SharedNode::find(v3, {2}), v2->at(1).get());
+    EXPECT_EQ(SharedNode::find(v3, {5}), nullptr);
+    EXPECT_THROW(SharedNode::setText(v3, {7}, "x"), Exception);
+
+    Node* node = v3->toNode();
+    EXPECT_EQ(node->name(), "root");
+    EXPECT_EQ(node->size(), 3u);
+    EXPECT_EQ(node->at(0)->at(1)->attribute("y"), "2");
+    EXPECT_EQ(node->at(1)->name(), "f");
+    delete node;
+}
+
+GTEST_TEST(Xml, Node_Insert)
+{
+    Node node("a");
+    EXPECT_TRUE(node.insert("x", "1"));
+    EXPECT_FALSE(node.insert("x", "2"));
+    EXPECT_EQ(node.attribute("x"), "1");
+
+    String key   = "y";
+    String value = "3";
+    EXPECT_TRUE(node.insert(std::move(key), std::move(value)));
+    EXPECT_EQ(node.attribute("y"), "3");
+
+    key   = "y";
+    value = "4";
+    EXPECT_FALSE(node.insert(std::move(key), std::move(value)));
+    EXPECT_EQ(key, "y");
+    EXPECT_EQ(value, "4");
+
+    StringStream ss;
+    ss << "<a x='1' x='2'/>";
+
+    File parser;
+    EXPECT_THROW(parser.read(ss), Exception);
+}
+
+GTEST_TEST(Xml, ViewFile_Read)
+{
+    String buffer = R"(<?xml version="1.0"?>
+<!-- comment -->
+<root count='3' scale="1.5" name="a&amp;b">
+    <item id="1"/>
+    <item id="2">text</item>
+    <skip><item id="4"/></skip>
+    <item id='3'/>
+</root>)";
+
+    ViewFile file;
+    file.read(std::move(buffer));
+
+    const ViewNode* root = file.root("root");
+    EXPECT_NE(nullptr, root);
+    EXPECT_EQ(root->int32("count"), 3);
+    EXPECT_EQ(root->float32("scale"), 1.5f);
+    EXPECT_EQ(root->attribute("name"), "a&b");
+    EXPECT_EQ(root->attribute("missing", "def"), "def");
+    EXPECT_EQ(root->size(), 4u);
+
+    const ViewNode* item = root->firstChildOf("item");
+    EXPECT_NE(nullptr, item);
+    EXPECT_EQ(item->int32("id"), 1);
+    item = item->nextSiblingOf("item");
+    EXPECT_EQ(item->int32("id"), 2);
+    EXPECT_EQ(item->text(), "text");
+    EXPECT_EQ(item->firstChild()->name(), "_text_node");
+    item = item->nextSiblingOf("item");
+    EXPECT_EQ(item->int32("id"), 3);
+    EXPECT_EQ(item->nextSiblingOf("item"), nullptr);
+
+    constexpr TypeFilter filter[] = {
+        {"root", 1},
+        {"item", 2},
+    };
+
+    ViewFile filtered(filter, 2);
+    filtered.attach(R"(<root><item/><skip><item/></skip><item>t</item></root>)");
+    root = filtered.root(1);
+    EXPECT_NE(nullptr, root);
+    EXPECT_EQ(root->size(), 2u);
+    for (const ViewNode* child : root->children())
+    {
+        EXPECT_TRUE(child->isTypeOf(2));
+        EXPECT_FALSE(child->hasChildren());
+    }
+
+    ViewFile bad;
+    EXPECT_THROW(bad.attach("<a><b></a>"), Exception);
+    EXPECT_THROW(bad.attach("<a x='1' x='2'/>"), Exception);
+    EXPECT_THROW(bad.attach("<a>"), Exception);
+}
+
+GTEST_TEST(Xml, Node_WideChildIndex)
+{
+    Node root("root");
+    for (int i = 0; i < 100; ++i)
+    {
+        Node* child = new Node(i % 2 ? "odd" : "even", i % 2);
+        child->insert("i", i);
+        root.addChild(child);
+    }
+
+    EXPECT_EQ(root.firstChildOf("odd")->int32("i"), 1);
+    EXPECT_EQ(root.firstChildOf(0)->int32("i"), 0);
+    EXPECT_TRUE(root.hasChild("even"));
+    EXPECT_FALSE(root.hasChild("none"));
+    EXPECT_EQ(root.firstChildOf("none"), nullptr);
+
+    NodeArray arr;
+    root.siblingsOf(arr, "odd");
+    EXPECT_EQ(arr.size(), 50u);
+    EXPECT_EQ(arr[1]->int32("i"), 3);
+
+    // the index must follow later mutations
+    root.addChild(new Node("late", 7));
+    EXPECT_TRUE(root.hasChild("late"));
+    EXPECT_EQ(root.firstChildOf(7)->name(), "late");
+
+    root.firstChildOf("late")->setTypeCode(8);
+    EXPECT_EQ(root.firstChildOf(7), nullptr);
+    EXPECT_EQ(root.firstChildOf(8)->name(), "late");
+
+    root.sort([](const Node* a, const Node* b)
+              { return a->int32("i") > b->int32("i"); });
+    EXPECT_EQ(root.firstChildOf("odd")->int32("i"), 99);
+
+    arr.clear();
+    root.childrenOf(0, arr);
+    EXPECT_EQ(arr.size(), 50u);
+    EXPECT_EQ(arr.front()->int32("i"), 98);
+
+    root.clearChildren();
+    EXPECT_FALSE(root.hasChild("odd"));
+}
+
+GTEST_TEST(Xml, Node_ChildRanges)
+{
+    Node root("root");
+    for (int i = 0; i < 10; ++i)
+    {
+        Node* child = new Node(i % 3 ? "a" : "b", i % 3);
+        child->insert("i", i);
+        root.addChild(child);
+    }
+
+    String seen;
+    for (const Node* node : root.siblingsOf("b"))
+        seen.append(node->attribute("i"));
+    EXPECT_EQ(seen, "0369");
+
+    const TypeRange ones = root.childrenOf((int64_t)1);
+    EXPECT_EQ(std::distance(ones.begin(), ones.end()), 3);
+    EXPECT_EQ((*ones.begin())->int32("i"), 1);
+    EXPECT_TRUE(root.childrenOf((int64_t)5).empty());
+    EXPECT_TRUE(root.siblingsOf("c").empty());
+    EXPECT_THROW(root.siblingsOf(""), Exception);
+
+#if defined(__cpp_lib_ranges)
+    static_assert(std::ranges::forward_range<TypeRange>);
+    static_assert(std::ranges::view<NameRange>);
+
+    auto large = root.childrenOf((int64_t)2) |
+                 std::views::filter([](const Node* node)
+                                    { return node->int32("i") > 4; });
+    EXPECT_EQ(std::ranges::distance(large), 2);
+#endif
+
+    // wide nodes take the same path through the index
+    for (int i = 10; i < (int)ChildIndexThreshold + 10; ++i)
+        root.addChild(new Node(i % 3 ? "a" : "b", i % 3));
+    EXPECT_EQ(std::distance(root.siblingsOf("b").begin(), root.siblingsOf("b").end()), 14);
+}
+
+GTEST_TEST(Xml, Node_Traversal)
+{
+    StringStream ss;
+    ss << "<a><b><c/><d/></b><e><f/></e><g/></a>";
+
+    File parser;
+    parser.read(ss);
+    const Node* root = parser.root("a");
+
+    String order;
+    EXPECT_TRUE(Node::preOrder(root,
+                               [&order](const Node* node)
+                               { order.append(node->name()); }));
+    EXPECT_EQ(order, "abcdefg");
+
+    order.clear();
+    EXPECT_TRUE(Node::preOrder(root,
+                               [&order](const Node* node)
+                               {
+                                   order.append(node->name());
+                                   return node->isTypeOf("b") ? TRAVERSE_SKIP : TRAVERSE_CONTINUE;
+                               }));
+    EXPECT_EQ(order, "abefg");
+
+    order.clear();
+    EXPECT_FALSE(Node::preOrder(root,
+                                [&order](const Node* node)
+                                {
+                                    order.append(node->name());
+                                    return !node->isTypeOf("e");
+                                }));
+    EXPECT_EQ(order, "abcde");
+
+    order.clear();
+    EXPECT_TRUE(Node::prePostOrder(
+        root,
+        [&order](const Node* node)
+        {
+            order.append(node->name());
+            return node->isTypeOf("e") ? TRAVERSE_SKIP : TRAVERSE_CONTINUE;
+        },
+        [&order](const Node*)
+        { order.push_back('/'); }));
+    EXPECT_EQ(order, "abc/d//e/g//");
+
+    // deeper than the local stack storage
+    Node deep("0");
+    Node* tail = &deep;
+    for (size_t i = 0; i < TraverseStackSize * 4; ++i)
+    {
+        Node* child = new Node("n");
+        tail->addChild(child);
+        tail = child;
+    }
+
+    size_t entered = 0, left = 0;
+    Node::prePostOrder(
+        &deep,
+        [&entered](const Node*)
+        { ++entered; },
+        [&left](const Node*)
+        { ++left; });
+    EXPECT_EQ(entered, TraverseStackSize * 4 + 1);
+    EXPECT_EQ(left, entered);
+}
+
+GTEST_TEST(Xml, Node_ParallelTraverse)
+{
+    // a few wide levels with a long chain under one of them
+    Node root("root");
+    int  total = 1;
+    for (int i = 0; i < 40; ++i)
+    {
+        Node* a = new Node("a", 1);
+        root.addChild(a);
+        ++total;
+        for (int j = 0; j < 50; ++j)
+        {
+            a->addChild(new Node("b", 2));
+            ++total;
+        }
+    }
+
+    Node* tail = root.at(3);
+    for (int i = 0; i < 500; ++i)
+    {
+        Node* c = new Node("c", 3);
+        tail->addChild(c);
+        tail = c;
+        ++total;
+    }
+
+    std::atomic<int> visited{0};
+    std::atomic<int> misordered{0};
+    std::atomic<int> found{0};
+
+    std::vector<std::atomic<bool>> seen(total);
+    std::unordered_map<const Node*, int> ids;
+    Node::preOrder(&root,
+                   [&ids](const Node* node)
+                   { ids.emplace(node, (int)ids.size()); });
+
+    EXPECT_TRUE(Node::parallelTraverse(
+        &root,
+        [&](const Node* node)
+        {
+            ++visited;
+            if (node->parent() && !seen[ids.at(node->parent())].load())
+                ++misordered;
+            seen[ids.at(node)].store(true);
+
+            // concurrent lookups that build the child index
+            if (node->isTypeOf(1) && node->firstChildOf(2))
+                ++found;
+        }));
+    EXPECT_EQ(visited.load(), total);
+    EXPECT_EQ(misordered.load(), 0);
+    EXPECT_EQ(found.load(), 40);
+
+    visited = 0;
+    EXPECT_FALSE(Node::parallelTraverse(&root,
+                                        [&visited](const Node* node)
+                                        {
+                                            ++visited;
+                                            return !node->isTypeOf(3);
+                                        }));
+    EXPECT_LT(visited.load(), total);
+
+    visited = 0;
+    EXPECT_TRUE(Node::parallelTraverse(&root,
+                                       [&visited](const Node* node)
+                                       {
+                                           ++visited;
+                                           return node->isTypeOf(1) ? TRAVERSE_SKIP : TRAVERSE_CONTINUE;
+                                       }));
+    EXPECT_EQ(visited.load(), 41);
+}
+
+struct BindVertex
+{
+    float x{0}, y{0};
+};
+
+struct BindMaterial
+{
+    String name;
+    bool   doubleSided{false};
+};
+
+struct BindMesh
+{
+    String                  name;
+    int32_t                 count{-1};
+    String                  label;
+    BindMaterial            material;
+    std::vector<BindVertex> vertices;
+};
+
+GTEST_TEST(Xml, Schema_Bind)
+{
+    const auto vertex = Schema<BindVertex>()
+                            .attribute("x", &BindVertex::x)
+                            .attribute("y", &BindVertex::y);
+
+    const auto material = Schema<BindMaterial>()
+                              .text(&BindMaterial::name)
+                              .attribute("double", &BindMaterial::doubleSided);
+
+    const auto mesh = Schema<BindMesh>()
+                          .attribute("name", &BindMesh::name)
+                          .attribute("count", &BindMesh::count)
+                          .element("label", &BindMesh::label)
+                          .child("material", &BindMesh::material, material)
+                          .children("v", &BindMesh::vertices, vertex);
+
+    const String buffer =
+        "<?xml version='1.0'?>"
+        "<scene>"
+        "  <mesh name='a &amp; b' count='2' unknown='x'>"
+        "    <label>first</label>"
+        "    <material double='true'>steel</material>"
+        "    <v x='1.5' y='2'/>"
+        "    <ignored><v x='9'/></ignored>"
+        "    <v x='-3' y='0.25'/>"
+        "  </mesh>"
+        "  <group><mesh name='b' count='oops'/></group>"
+        "</scene>";
+
+    std::vector<BindMesh> meshes;
+    bindAll(buffer, "mesh", mesh, meshes);
+
+    ASSERT_EQ(meshes.size(), 2u);
+    EXPECT_EQ(meshes[0].name, "a & b");
+    EXPECT_EQ(meshes[0].count, 2);
+    EXPECT_EQ(meshes[0].label, "first");
+    EXPECT_EQ(meshes[0].material.name, "steel");
+    EXPECT_TRUE(meshes[0].material.doubleSided);
+    ASSERT_EQ(meshes[0].vertices.size(), 2u);
+    EXPECT_FLOAT_EQ(meshes[0].vertices[0].x, 1.5f);
+    EXPECT_FLOAT_EQ(meshes[0].vertices[1].x, -3.f);
+    EXPECT_FLOAT_EQ(meshes[0].vertices[1].y, 0.25f);
+
+    EXPECT_EQ(meshes[1].name, "b");
+    EXPECT_EQ(meshes[1].count, -1);  // not a number, so the default stays
+    EXPECT_TRUE(meshes[1].vertices.empty());
+}
+
+GTEST_TEST(Xml, Node_SortByKey)
+{
+    // wide enough to take the parallel path
+    const int size = (int)ParallelSortThreshold + 1000;
+
+    Node root("root");
+    for (int i = 0; i < size; ++i)
+    {
+        Node* child = new Node("n");
+        child->insert("order", (i * 7919) % 101);
+        child->insert("i", i);
+        root.addChild(child);
+    }
+
+    int calls = 0;
+    root.sortByKey([&calls](const Node* node)
+                   {
+                       ++calls;
+                       return node->int32("order");
+                   });
+    EXPECT_EQ(calls, size);
+
+    bool ordered = true;
+    for (int i = 1; i < size && ordered; ++i)
+    {
+        const Node* a = root.at(i - 1);
+        const Node* b = root.at(i);
+
+        const int ka = a->int32("order"), kb = b->int32("order");
+        ordered = ka < kb || (ka == kb && a->int32("i") < b->int32("i"));
+    }
+    EXPECT_TRUE(ordered);
+
+    // sibling links follow the new order
+    EXPECT_EQ(root.at(0)->nextSiblingOf("n"), root.at(1));
+    EXPECT_EQ(root.at(size - 1)->nextSiblingOf("n"), nullptr);
+
+    root.sort([](const Node* a, const Node* b)
+              { return a->int32("i") > b->int32("i"); });
+    EXPECT_EQ(root.at(0)->int32("i"), size - 1);
+    EXPECT_EQ(root.at(size - 2)->nextSiblingOf("n")->int32("i"), 0);
+
+    // comparators with the NodeSortFunc signature still work
+    root.sort([](Node* a, Node* b)
+              { return a->int32("i") < b->int32("i"); });
+    EXPECT_EQ(root.at(0)->int32("i"), 0);
+    EXPECT_EQ(root.at(0)->nextSiblingOf("n")->int32("i"), 1);
+}
+
+GTEST_TEST(Xml, Node_Hash)
+{
+    StringStream a, b;
+    a << "<root><x a='1' b='2'>t</x><y><z/></y><w/></root>";
+    b << "<root><x b='2' a='1'>t</x><y><z/></y><w/></root>";
+
+    File fa, fb;
+    fa.read(a);
+    fb.read(b);
+
+    Node* ra = fa.root("root");
+    Node* rb = fb.root("root");
+
+    // attribute order does not matter
+    EXPECT_TRUE(ra->isSameAs(rb));
+    EXPECT_NE(ra->hash(), ra->firstChildOf("x")->hash());
+
+    NodePairArray changed;
+    Node::changes(ra, rb, changed);
+    EXPECT_TRUE(changed.empty());
+
+    // a change below clears the cached hashes up to the root
+    const uint64_t before = rb->hash();
+    rb->firstChildOf("y")->firstChildOf("z")->insert("c", 3);
+    EXPECT_NE(rb->hash(), before);
+    EXPECT_FALSE(ra->isSameAs(rb));
+    EXPECT_TRUE(ra->firstChildOf("x")->isSameAs(rb->firstChildOf("x")));
+
+    rb->firstChildOf("w")->text("changed");
+
+    Node::changes(ra, rb, changed);
+    ASSERT_EQ(changed.size(), 2u);
+    EXPECT_EQ(changed[0].second->name(), "z");
+    EXPECT_EQ(changed[1].second->name(), "w");
+
+    // restoring the text only rehashes the modified path
+    rb->firstChildOf("w")->text("");
+    EXPECT_FALSE(ra->isSameAs(rb));
+    rb->firstChildOf("y")->addChild(new Node("extra"));
+    changed.clear();
+    Node::changes(ra, rb, changed);
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(changed[0].second->name(), "y");
+}
+
+GTEST_TEST(Xml, Diff_Apply)
+{
+    StringStream a, b;
+    a << "<root>"
+         "<item id='1' v='a'/><item id='2' v='b'/><item id='3' v='c'/>"
+         "<item id='4' v='d'/><item id='5' v='e'/>"
+         "<group><x/><y t='1'>text</y></group>"
+         "<gone/>"
+         "</root>";
+    b << "<root>"
+         "<item id='4' v='d'/><item id='1' v='a'/><item id='2' v='B'/>"
+         "<item id='3' v='c' n='new'/><item id='6' v='f'/><item id='5' v='e'/>"
+         "<group><x/><y>other</y><z/></group>"
+         "</root>";
+
+    File fa, fb;
+    fa.read(a);
+    fb.read(b);
+
+    DiffScript script;
+    Diff().compare(fa.tree(), fb.tree(), script);
+
+    size_t moves = 0, inserts = 0, deletes = 0;
+    for (const DiffEdit& edit : script)
+    {
+        moves += edit.op == DIFF_MOVE;
+        inserts += edit.op == DIFF_INSERT;
+        deletes += edit.op == DIFF_DELETE;
+    }
+
+    // only item 4 moves, item 6 and z are new and gone is removed
+    EXPECT_EQ(moves, 1u);
+    EXPECT_EQ(inserts, 2u);
+    EXPECT_EQ(deletes, 1u);
+
+    Node* copy = fa.tree()->clone();
+    Diff::apply(copy, script);
+    EXPECT_TRUE(copy->isSameAs(fb.tree()));
+
+    // nothing to do for equal trees
+    script.clear();
+    Diff().compare(copy, fb.tree(), script);
+    EXPECT_TRUE(script.empty());
+    delete copy;
+
+    // without ids the items are paired by hash and then by position
+    script.clear();
+    Diff("").compare(fa.tree(), fb.tree(), script);
+    copy = fa.tree()->clone();
+    Diff::apply(copy, script);
+    EXPECT_TRUE(copy->isSameAs(fb.tree()));
+    delete copy;
+}
+
+GTEST_TEST(Xml, Diff_Reorder)
+{
+    // every permutation of a short list must round trip
+    int order[] = {0, 1, 2, 3, 4};
+    do
+    {
+        Node from("root"), to("root");
+        for (int i = 0; i < 5; ++i)
+        {
+            Node* f = new Node("n");
+            f->insert("id", i);
+            from.addChild(f);
+
+            Node* t = new Node("n");
+            t->insert("id", order[i]);
+            to.addChild(t);
+        }
+
+        DiffScript script;
+        Diff().compare(&from, &to, script);
+        Diff::apply(&from, script);
+        EXPECT_TRUE(from.isSameAs(&to));
+        EXPECT_LE(script.size(), 4u);
+    } while (std::next_permutation(order, order + 5));
+
+    // a wide level, interleaving the two halves and adding new children
+    const int size = 20000;
+
+    Node from("root"), to("root");
+    for (int i = 0; i < size; ++i)
+    {
+        Node* f = new Node("n");
+        f->insert("id", i);
+        from.addChild(f);
+
+        Node* t = new Node("n");
+        t->insert("id", i % 2 ? size / 2 + i / 2 : i / 2);
+        to.addChild(t);
+
+        if (i % 1000 == 0)
+            to.addChild(new Node("extra"));
+    }
+
+    DiffScript script;
+    Diff().compare(&from, &to, script);
+    Diff::apply(&from, script);
+    EXPECT_TRUE(from.isSameAs(&to));
+    EXPECT_LT(script.size(), (size_t)size);
+}
+
+GTEST_TEST(Xml, MemoryUsage)
+{
+    StringStream ss;
+    ss << "<root><item name='a long attribute value that is not small'/>"
+          "<item>some text that is long enough to be stored on the heap</item>"
+          "</root>";
+
+    File file;
+    file.read(ss);
+
+    const MemoryUsage tree = file.tree()->memoryUsage();
+    EXPECT_EQ(tree.nodes, 5u);  // base, root, two items and a text node
+    EXPECT_EQ(tree.nodeBytes, tree.nodes * sizeof(Node));
+    EXPECT_GT(tree.attributeBytes, 40u);
+    EXPECT_GT(tree.textBytes, 40u);
+    EXPECT_GT(tree.childBytes, 0u);
+    EXPECT_EQ(tree.indexBytes, 0u);
+
+    const MemoryUsage doc = file.memoryUsage();
+    EXPECT_EQ(doc.nodes, tree.nodes);
+    EXPECT_GE(doc.total(), tree.total());
+
+    // a wide node pays for its child index once it is built
+    Node* root = file.root("root");
+    for (size_t i = 0; i < ChildIndexThreshold; ++i)
+        root->addChild(new Node("extra"));
+    EXPECT_TRUE(root->hasChild("extra"));
+    EXPECT_GT(root->memoryUsage().indexBytes, 0u);
+
+    MemoryUsage sum;
+    sum += tree;
+    sum += tree;
+    EXPECT_EQ(sum.total(), tree.total() * 2);
+}
+
+GTEST_TEST(Xml, Writer_Format)
+{
+    Node root("a");
+    Node* b = new Node("b");
+    b->insert("k", "v");
+    root.addChild(b);
+    Node* c = new Node("c");
+    c->text("t");
+    c->addChild(new Node("d"));
+    root.addChild(c);
+
+    String str;
+    Writer::toString(str, &root, true);
+    EXPECT_EQ(str, "<a><b k=\"v\"/><c>t<d/></c></a>");
+
+    Writer::toString(str, &root, false, 2);
+    EXPECT_EQ(str,
+              "<a>\n"
+              "  <b k=\"v\"/>\n"
+              "  <c>t    <d/>\n"
+              "</c>\n"
+              "</a>\n");
+
+    // deeper than the precomputed indentation
+    Node  deep("n");
+    Node* tail = &deep;
+    for (int i = 0; i < 40; ++i)
+    {
+        Node* child = new Node("n");
+        tail->addChild(child);
+        tail = child;
+    }
+
+    Writer::toString(str, &deep, false, 4);
+    EXPECT_NE(str.find("\n" + String(160, ' ') + "<n/>\n"), String::npos);
+    EXPECT_EQ(str.find(String(161, ' ')), String::npos);
+}
+
+GTEST_TEST(Xml, Writer_LargeOutput)
+{
+    Node root("root");
+    // stays under the parser's tag limit
+    const String pad(100, 'x');
+    for (int i = 0; i < 1000; ++i)
+    {
+        Node* item = new Node("item");
+        item->insert("i", i);
+        item->insert("pad", pad);
+        root.addChild(item);
+    }
+
+    StringStream ss;
+    Writer writer(&root);
+    writer.write(ss);
+
+    const String out = ss.str();
+    EXPECT_GT(out.size(), WriteBufferSize);
+    EXPECT_EQ(out.rfind("</root>"), out.size() - 7);
+
+    File file;
+    file.read(ss);
+    EXPECT_EQ(file.root("root")->size(), 1000u);
+    EXPECT_EQ(file.root("root")->at(999)->int32("i"), 999);
+}
+
+GTEST_TEST(Xml, Writer_Measure)
+{
+    Node root("root");
+    for (int i = 0; i < 2000; ++i)
+    {
+        Node* item = new Node("item");
+        item->insert("i", i);
+        item->insert("v", "a < b & c");
+        item->text("\"t\"");
+        root.addChild(item);
+    }
+
+    StringStream ss;
+    Writer writer(&root);
+    writer.setMinify(false);
+    writer.write(ss);
+
+    const String expected = ss.str();
+    EXPECT_GT(expected.size(), WriteBufferSize);
+    EXPECT_EQ(writer.measure(), expected.size());
+
+    String buffer(expected.size(), '\0');
+    EXPECT_EQ(writer.writeTo(buffer.data(), buffer.size()), expected.size());
+    EXPECT_EQ(buffer, expected);
+
+    // one byte short
+    EXPECT_THROW(writer.writeTo(buffer.data(), buffer.size() - 1), Exception);
+
+    String str;
+    Writer::toString(str, &root, false, 2);
+    EXPECT_EQ(str.size(), Writer::measure(&root, false, 2));
+
+    OutputStringStream oss;
+    Writer::toStream(oss, &root, false, 2);
+    EXPECT_EQ(str, oss.str());
+}
+
+GTEST_TEST(Xml, Writer_Parallel)
+{
+    Node root("root");
+    root.insert("name", "a & b");
+    for (int i = 0; i < 50; ++i)
+    {
+        Node* group = new Node("group");
+        group->insert("i", i);
+        if (i % 3 == 0)
+            group->text("g < " + std::to_string(i));
+        for (int j = 0; j < i % 7; ++j)
+        {
+            Node* item = new Node("item");
+            item->insert("j", j);
+            if (j % 2)
+                item->text("t");
+            group->addChild(item);
+        }
+        root.addChild(group);
+    }
+
+    for (const bool minify : {true, false})
+    {
+        for (const int offset : {0, 3})
+        {
+            Writer writer(&root);
+            writer.setMinify(minify);
+            writer.setIndent(4);
+            writer.setIndentOffset(offset);
+
+            OutputStringStream expected, actual;
+            writer.write(expected);
+            writer.writeParallel(actual, 4);
+            EXPECT_EQ(actual.str(), expected.str());
+        }
+    }
+
+    // a single node and an empty writer
+    Node         leaf("leaf");
+    StringStream a, b;
+    Writer(&leaf).write(a);
+    Writer(&leaf).writeParallel(b);
+    EXPECT_EQ(a.str(), b.str());
+
+    OutputStringStream empty;
+    Writer(nullptr).writeParallel(empty);
+    EXPECT_EQ(empty.str(), "<?xml version=\"1.0\"?>\n");
+}
+
+GTEST_TEST(Xml, StreamWriter_Output)
+{
+    Node root("a");
+    Node* b = new Node("b");
+    b->insert("k", "v & w");
+    root.addChild(b);
+    Node* c = new Node("c");
+    c->text("t");
+    c->addChild(new Node("d"));
+    root.addChild(c);
+
+    const auto emit = [](StreamWriter& out)
+    {
+        out.startElement("a");
+        out.startElement("b");
+        out.attribute("k", "v & w");
+        out.endElement();
+        out.startElement("c");
+        out.text("t");
+        out.startElement("d");
+        out.endElement();
+        out.endElement();
+        out.endElement();
+        out.endDocument();
+    };
+
+    for (const int format : {Minify, Indent2, Indent4})
+    {
+        OutputStringStream streamed, expected;
+
+        StreamWriter out(streamed, format);
+        emit(out);
+
+        Writer writer(&root);
+        writer.setMinify((format & Minify) != 0);
+        writer.setIndent(format & Indent4 ? 4 : 2);
+        writer.setShowXmlHeader(false);
+        writer.write(expected);
+
+        EXPECT_EQ(streamed.str(), expected.str());
+    }
+
+    OutputStringStream oss;
+    StreamWriter       bad(oss, Minify);
+    EXPECT_THROW(bad.endElement(), Exception);
+    EXPECT_THROW(bad.text("x"), Exception);
+    bad.startElement("a");
+    bad.text("x");
+    EXPECT_THROW(bad.attribute("k", 1), Exception);
+    EXPECT_THROW(bad.endDocument(), Exception);
+    bad.endElement();
+    EXPECT_THROW(bad.startElement("b"), Exception);
+    bad.endDocument();
+    EXPECT_EQ(bad.depth(), 0u);
+    EXPECT_EQ(oss.str(), "<a>x</a>");
+
+    // a lone empty root, which Writer indents by one space
+    Node lone("a");
+    for (const int format : {Minify, Indent2})
+    {
+        OutputStringStream streamed, expected;
+
+        StreamWriter out(streamed, format);
+        out.startElement("a");
+        out.endElement();
+        out.endDocument();
+
+        Writer writer(&lone);
+        writer.setMinify(format == Minify);
+        writer.setShowXmlHeader(false);
+        writer.write(expected);
+
+        EXPECT_EQ(streamed.str(), format == Minify ? "<a/>" : "<a/>\n");
+        EXPECT_EQ(expected.str(), format == Minify ? "<a/>" : " <a/>\n");
+    }
+
+    // any integer type, and floating point
+    OutputStringStream numbers;
+    StreamWriter       num(numbers, Minify);
+    num.startElement("n");
+    num.attribute("a", (int64_t)-9000000000);
+    num.attribute("b", (size_t)18000000000);
+    num.attribute("c", (uint16_t)7);
+    num.attribute("d", 0.5);
+    num.endElement();
+    num.endDocument();
+    EXPECT_EQ(numbers.str(), "<n a=\"-9000000000\" b=\"18000000000\" c=\"7\" d=\"" + Char::toString(0.5) + "\"/>");
+
+    // buffered output reaches the stream without endDocument
+    OutputStringStream early;
+    {
+        StreamWriter out(early, Minify);
+        out.startElement("a");
+        out.endElement();
+    }
+    EXPECT_EQ(early.str(), "<a/>");
+}
+
+GTEST_TEST(Xml, Binary_RoundTrip)
+{
+    StringStream ss;
+    ss << R"(<root count="3"><item id="1" v="a &amp; b">one</item>)"
+          R"(<item id="2"/><group><item id="3">three</item></group></root>)";
+
+    File file;
+    file.read(ss);
+    file.tree()->firstChild()->setTypeCode(-42);
+    file.root("root")->at(1)->setTypeCode(300);
+
+    String data;
+    Binary::toString(data, file.tree());
+    EXPECT_EQ(data.substr(0, 4), BinaryMagic);
+
+    Node* copy = Binary::read(data);
+    ASSERT_NE(copy, nullptr);
+    EXPECT_TRUE(copy->isSameAs(file.tree()));
+    EXPECT_EQ(copy->firstChild()->type(), -42);
+    EXPECT_EQ(copy->firstChild()->at(1)->type(), 300);
+    EXPECT_EQ(copy->firstChild()->at(1)->parent(), copy->firstChild());
+
+    String a, b;
+    Writer::toString(a, file.root("root"));
+    Writer::toString(b, copy->firstChild());
+    EXPECT_EQ(a.size(), b.size());
+    delete copy;
+
+    StringStream bin;
+    Binary::write(bin, file.tree());
+    copy = Binary::read(bin);
+    EXPECT_TRUE(copy->isSameAs(file.tree()));
+    delete copy;
+
+    EXPECT_THROW(Binary::read(std::string_view("XML1")), Exception);
+    EXPECT_THROW(Binary::read(std::string_view(data).substr(0, data.size() - 1)), Exception);
+    EXPECT_THROW(Binary::read(data + "x"), Exception);
+
+    // counts that are larger than the rest of the input
+    const auto binary = [](const char* bytes, const size_t len)
+    { return String(BinaryMagic) + String(bytes, len); };
+
+    EXPECT_THROW(Binary::read(binary("\xff\xff\xff\xff\x0f", 5)), Exception);
+    EXPECT_THROW(Binary::read(binary("\x01\x01" "a" "\x00\x01\xff\xff\x0f\x00\x00", 10)), Exception);
+    EXPECT_THROW(Binary::read(binary("\x01\x01" "a" "\x00\x01\x00\x00\x7f", 8)), Exception);
+
+    copy = Binary::read(binary("\x01\x01" "a" "\x00\x01\x00\x00\x00", 8));
+    EXPECT_EQ(copy->name(), "a");
+    delete copy;
+}
+
+GTEST_TEST(Xml, Snapshot_Query)
+{
+    StringStream ss;
+    ss << R"(<root count="3"><item id="1" v="a &amp; b">one</item>)"
+          R"(<item id="2"/><group><item id="3">three</item></group></root>)";
+
+    File file;
+    file.read(ss);
+    file.root("root")->at(1)->setTypeCode(7);
+
+    String data;
+    Snapshot::toString(data, file.tree());
+
+    Snapshot snap(data);
+    EXPECT_NO_THROW(snap.verify());
+
+    const SnapshotNode root = snap.root().firstChildOf("root");
+    ASSERT_TRUE(root);
+    EXPECT_FALSE(snap.root().parent());
+    EXPECT_EQ(root.int32("count"), 3);
+    EXPECT_EQ(root.size(), 3u);
+    EXPECT_EQ(root.at(0).attribute("v"), "a & b");
+    EXPECT_EQ(root.at(0).text(), "one");
+    EXPECT_EQ(root.at(1).type(), 7);
+    EXPECT_FALSE(root.at(3));
+    EXPECT_EQ(root.firstChildOf(7).int32("id"), 2);
+    EXPECT_EQ(root.at(2).firstChildOf("item").parent().name(), "group");
+    EXPECT_EQ(root.at(2).at(0).text(), "three");
+
+    size_t items = 0;
+    for (const SnapshotNode child : root.children())
+        items += child.isTypeOf("item");
+    EXPECT_EQ(items, 2u);
+
+    // one node per Node in the source tree
+    size_t nodes = 0;
+    Node::preOrder(file.tree(), [&nodes](const Node*) { ++nodes; });
+    EXPECT_EQ(snap.size(), nodes);
+
+    EXPECT_THROW(Snapshot(std::string_view(data).substr(0, 16)), Exception);
+    EXPECT_THROW(Snapshot(std::string_view(data).substr(0, data.size() - 1)), Exception);
+
+    String bad = data;
+    bad[0]     = 'Y';
+    EXPECT_THROW(Snapshot{bad}, Exception);
+
+    // a child range that points back up the tree
+    bad = data;
+    auto* rec       = (SnapshotRecord*)(bad.data() + sizeof(SnapshotHeader));
+    rec->firstChild = 0;
+    Snapshot corrupt(bad);
+    EXPECT_THROW(corrupt.verify(), Exception);
+}
+
+GTEST_TEST(Xml, Writer_Escape)
+{
+    // long enough to cross the vector width more than once
+    const String clean(70, 'a');
+    EXPECT_EQ(SpecialChar::findEscape(clean), clean.size());
+    EXPECT_EQ(SpecialChar::findEscape(clean + "\""), clean.size());
+    EXPECT_EQ(SpecialChar::findEscape(String(33, 'b') + "<" + clean), 33u);
+    EXPECT_EQ(SpecialChar::findEscape(clean + "'" + clean), clean.size());
+    EXPECT_EQ(SpecialChar::findEscape(""), 0u);
+
+    String enc;
+    SpecialChar::encode(enc, "a<b & \"c\" > 'd'");
+    EXPECT_EQ(enc, "a&lt;b &amp; &quot;c&quot; &gt; &apos;d&apos;");
+
+    Node root("root");
+    root.insert("v", "x < y & \"z\" 'w'" + clean);
+    root.text("1 < 2 && 3 > 2");
+
+    String out;
+    Writer::toString(out, &root);
+    EXPECT_EQ(out.find('"', out.find("v=\"") + 3), out.rfind('"'));
+
+    // both readers turn the entities back into the original values
+    StringStream ss;
+    ss << out;
+    File file;
+    file.read(ss);
+    EXPECT_EQ(file.root("root")->attribute("v"), root.attribute("v"));
+    EXPECT_EQ(file.root("root")->text(), root.text());
+
+    ViewFile view;
+    view.read(String(out));
+    EXPECT_EQ(view.root("root")->attribute("v"), root.attribute("v"));
+    EXPECT_EQ(view.root("root")->text(), root.text());
+}
+
+GTEST_TEST(Xml, File_TypeIndex)
+{
+    constexpr TypeFilter filter[] = {
+        {"root", 1},
+        {   "a", 2},
+        {   "b", 3},
+    };
+
+    StringStream ss;
+    ss << "<root><a i='0'><b i='1'/></a><skip><a i='2'/><b i='3'/></skip><b i='4'><a i='5'/></b></root>";
+
+    File parser(filter, 3);
+    parser.setIndexTypes(true);
+    parser.read(ss);
+
+    const NodeArray& a = parser.nodesOf(2);
+    EXPECT_EQ(a.size(), 2u);
+    EXPECT_EQ(a[0]->int32("i"), 0);
+    EXPECT_EQ(a[1]->int32("i"), 5);
+
+    const NodeArray& b = parser.nodesOf(3);
+    EXPECT_EQ(b.size(), 2u);
+    EXPECT_EQ(b[0]->int32("i"), 1);
+    EXPECT_EQ(b[1]->int32("i"), 4);
+
+    EXPECT_EQ(parser.nodesOf(1).size(), 1u);
+    EXPECT_TRUE(parser.nodesOf(4).empty());
+
+    const Node* tree = parser.detachRoot();
+    EXPECT_TRUE(parser.nodesOf(2).empty());
+    delete tree;
+}
+
+GTEST_TEST(Xml, Query_Select)
+{
+    StringStream ss;
+    ss << "<root>"
+          "<item id='1'/>"
+          "<item id='2' x='a'><item id='3'/></item>"
+          "<group><item id='4' x='b'/><item id='5'/></group>"
+          "<item id='6'>text</item>"
+          "</root>";
+
+    File parser;
+    parser.read(ss);
+    const Node* tree = parser.tree();
+
+    const auto ids = [tree](const String& expr)
+    {
+        String res;
+        Query(expr).forEach(tree,
+                            [&res](const Node* node)
+                            {
+                                if (!res.empty())
+                                    res.push_back(',');
+                                res += node->attribute("id");
+                            });
+        return res;
+    };
+
+    EXPECT_EQ(ids("root/item"), "1,2,6");
+    EXPECT_EQ(ids("/root/item"), "1,2,6");
+    EXPECT_EQ(ids("//item"), "1,2,3,4,5,6");
+    EXPECT_EQ(ids("root//item"), "1,2,3,4,5,6");
+    EXPECT_EQ(ids("root/*/item"), "3,4,5");
+    EXPECT_EQ(ids("//item[@x]"), "2,4");
+    EXPECT_EQ(ids("//item[@x='b']"), "4");
+    EXPECT_EQ(ids("root/item[2]"), "2");
+    EXPECT_EQ(ids("//item[1]"), "1,3,4");
+    EXPECT_EQ(ids("//item[last()]"), "3,5,6");
+    EXPECT_EQ(ids("root/item[@id][last()]"), "6");
+    EXPECT_EQ(ids("//item//item"), "3");
+    EXPECT_EQ(ids("root/none"), "");
+
+    const Query query("//item");
+    EXPECT_EQ(query.count(tree), 6u);
+    EXPECT_EQ(query.first(tree)->attribute("id"), "1");
+
+    NodeArray arr;
+    Query("root/group/*").select(tree, arr);
+    EXPECT_EQ(arr.size(), 2u);
+
+    EXPECT_THROW(Query("root/item[0]"), Exception);
+    EXPECT_THROW(Query("root/item[@id='1"), Exception);
+    EXPECT_THROW(Query(""), Exception);
+}
+
+GTEST_TEST(Xml, Node_TypedAttributes)
+{
+    Node node("a");
+    node.insert("i", " 42");
+    node.insert("n", "-7");
+    node.insert("f", "1.25");
+    node.insert("p", "+3.5");
+    node.insert("bad", "x1");
+    node.insert("a_long_attribute_name_that_does_not_fit", "12");
+
+    EXPECT_EQ(node.int32("i"), 42);
+    EXPECT_EQ(node.int64("n"), -7);
+    EXPECT_EQ(node.int16("n"), -7);
+    EXPECT_EQ(node.float32("f"), 1.25f);
+    EXPECT_EQ(node.float64("p"), 3.5);
+    EXPECT_EQ(node.int32("bad", 9), 9);
+    EXPECT_EQ(node.int32("missing", 5), 5);
+    EXPECT_EQ(node.float32("missing", 2.f), 2.f);
+    EXPECT_EQ(node.int32(String("a_long_attribute_name_that_does_not_fit")), 12);
+}
+
+GTEST_TEST(Xml, Node_StringViewLookup)
+{
+    StringStream ss;
+    ss << "<root id='r'><mesh name='a'/><item/><mesh name='b'/></root>";
+
+    File parser;
+    parser.read(ss);
+
+    const std::string_view rootName = "root";
+    const Node*            root     = parser.tree()->firstChildOf(rootName);
+    EXPECT_NE(nullptr, root);
+    EXPECT_TRUE(root->isTypeOf(rootName));
+    EXPECT_TRUE(root->contains(std::string_view("id")));
+    EXPECT_EQ(root->attribute(std::string_view("id")), "r");
+    EXPECT_TRUE(root->hasChild(std::string_view("item")));
+
+    const Node* mesh = root->firstChildOf("mesh");
+    EXPECT_EQ(mesh->attribute("name"), "a");
+    mesh = mesh->nextSiblingOf(std::string_view("mesh"));
+    EXPECT_EQ(mesh->attribute("name"), "b");
+
+    constexpr TypeFilter filter[] = {
+        {"root", 1},
+        {"mesh", 2},
+    };
+
+    TypeFilterMap map;
+    makeTypeFilter(map, filter, 2);
+
+    int64_t code = 0;
+    EXPECT_TRUE(findTypeCode(map, std::string_view("mesh"), code));
+    EXPECT_EQ(code, 2);
+    EXPECT_FALSE(findTypeCode(map, "item", code));
+}
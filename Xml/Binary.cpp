@@ -0,0 +1,262 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/Binary.h"
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include "Utils/Exception.h"
+#include "Xml/Node.h"
+
+namespace Rt2::Xml
+{
+    using StringTable = std::unordered_map<std::string_view, size_t>;
+
+    // The smallest encoding of a string is its length, of an attribute
+    // its key and an empty value, and of a node its five varints.
+    constexpr size_t MinStringBytes    = 1;
+    constexpr size_t MinAttributeBytes = 2;
+    constexpr size_t MinNodeBytes      = 5;
+
+    static void putVarint(String& dest, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            dest.push_back((char)((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        dest.push_back((char)value);
+    }
+
+    static void putBytes(String& dest, const std::string_view str)
+    {
+        putVarint(dest, str.size());
+        dest.append(str.data(), str.size());
+    }
+
+    static size_t intern(StringTable& table, std::vector<std::string_view>& order, const std::string_view str)
+    {
+        const auto [it, inserted] = table.emplace(str, order.size());
+        if (inserted)
+            order.push_back(str);
+        return it->second;
+    }
+
+    class BinaryReader
+    {
+    private:
+        std::string_view _data;
+        size_t           _pos{0};
+
+    public:
+        explicit BinaryReader(const std::string_view data) :
+            _data(data)
+        {
+        }
+
+        [[noreturn]] static void error()
+        {
+            throw Exception("invalid or truncated binary document");
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                if (_pos >= _data.size())
+                    error();
+
+                const uint8_t byte = (uint8_t)_data[_pos++];
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+            error();
+        }
+
+        std::string_view bytes()
+        {
+            const uint64_t len = varint();
+            if (len > _data.size() - _pos)
+                error();
+
+            const std::string_view str = _data.substr(_pos, (size_t)len);
+            _pos += (size_t)len;
+            return str;
+        }
+
+        /**
+         * \brief Reads the number of items that follow, each of which takes
+         * at least minBytes, and checks that there is room for all of them.
+         */
+        uint64_t count(const size_t minBytes)
+        {
+            const uint64_t value = varint();
+            if (value > (_data.size() - _pos) / minBytes)
+                error();
+            return value;
+        }
+
+        std::string_view take(const size_t len)
+        {
+            if (len > _data.size() - _pos)
+                error();
+
+            const std::string_view str = _data.substr(_pos, len);
+            _pos += len;
+            return str;
+        }
+
+        bool atEnd() const
+        {
+            return _pos >= _data.size();
+        }
+    };
+
+    void Binary::toString(String& dest, const Node* root)
+    {
+        dest.clear();
+        if (!root)
+            throw Exception("invalid node supplied to Binary::toString");
+
+        // The nodes are encoded first so that the string
+        // table is complete by the time it is written.
+        StringTable                   table;
+        std::vector<std::string_view> order;
+        String                        body;
+
+        Node::preOrder(
+            root,
+            [&](const Node* node)
+            {
+                putVarint(body, intern(table, order, node->name()));
+
+                // zigzag, so the common -1 takes one byte
+                const int64_t type = node->type();
+                putVarint(body, ((uint64_t)type << 1) ^ (uint64_t)(type >> 63));
+
+                putVarint(body, node->attributes().size());
+                for (const auto& [key, value] : node->attributes())
+                {
+                    putVarint(body, intern(table, order, key));
+                    putBytes(body, value);
+                }
+
+                putBytes(body, node->text());
+                putVarint(body, node->size());
+            });
+
+        dest.reserve(BinaryMagic.size() + body.size() + table.size() * 8);
+        dest.append(BinaryMagic.data(), BinaryMagic.size());
+
+        putVarint(dest, order.size());
+        for (const std::string_view str : order)
+            putBytes(dest, str);
+
+        dest.append(body);
+    }
+
+    void Binary::write(OStream& output, const Node* root)
+    {
+        String data;
+        toString(data, root);
+        output.write(data.data(), (std::streamsize)data.size());
+    }
+
+    Node* Binary::read(const std::string_view data)
+    {
+        BinaryReader reader(data);
+        if (reader.take(BinaryMagic.size()) != BinaryMagic)
+            throw Exception("missing binary document header");
+
+        std::vector<String> strings((size_t)reader.count(MinStringBytes));
+        for (String& str : strings)
+            str = String(reader.bytes());
+
+        const auto lookup = [&strings](const uint64_t idx) -> const String&
+        {
+            if (idx >= strings.size())
+                BinaryReader::error();
+            return strings[(size_t)idx];
+        };
+
+        // the nodes that still expect children,
+        // with the number they are waiting for
+        std::vector<std::pair<Node*, uint64_t>> stack;
+
+        Node* root = nullptr;
+        try
+        {
+            do
+            {
+                const String&  name = lookup(reader.varint());
+                const uint64_t zz   = reader.varint();
+
+                Node* node = new Node(name, (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1));
+                if (stack.empty())
+                    root = node;
+                else
+                {
+                    stack.back().first->addChild(node);
+                    --stack.back().second;
+                }
+
+                for (uint64_t i = reader.count(MinAttributeBytes); i > 0; --i)
+                {
+                    const String& key = lookup(reader.varint());
+                    node->insert(String(key), String(reader.bytes()));
+                }
+
+                if (const std::string_view text = reader.bytes();
+                    !text.empty())
+                    node->text(String(text));
+
+                if (const uint64_t children = reader.count(MinNodeBytes); children > 0)
+                    stack.emplace_back(node, children);
+
+                while (!stack.empty() && stack.back().second == 0)
+                    stack.pop_back();
+
+            } while (!stack.empty());
+        }
+        catch (...)
+        {
+            delete root;
+            throw;
+        }
+
+        if (!reader.atEnd())
+        {
+            delete root;
+            BinaryReader::error();
+        }
+        return root;
+    }
+
+    Node* Binary::read(IStream& input)
+    {
+        const String data((std::istreambuf_iterator<char>(input)),
+                          std::istreambuf_iterator<char>());
+        return read(data);
+    }
+
+}  // namespace Rt2::Xml
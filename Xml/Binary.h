@@ -0,0 +1,81 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <string_view>
+#include "Utils/String.h"
+
+namespace Rt2::Xml
+{
+    class Node;
+
+    /**
+     * \brief The first four bytes of every binary document.
+     */
+    constexpr std::string_view BinaryMagic = "XMB1";
+
+    /**
+     * \brief Saves and loads Node trees in a compact binary format.
+     *
+     * Reloading a tree this way skips tokenizing and parsing, and the
+     * decoded tree is equal to the saved one by Node::isSameAs. Names and
+     * attribute keys are stored once in a string table and referenced by
+     * index. Counts, lengths and type codes are varints, and attribute
+     * values and text are stored as raw bytes, so nothing is escaped.
+     *
+     * The layout is the magic, the string table as a count followed by
+     * each string's length and bytes, then every node in document order as
+     * its name index, type code, attributes, text and child count.
+     *
+     * \code{.cpp}
+     * Xml::Binary::write(cache, file.tree());
+     *
+     * Xml::Node* tree = Xml::Binary::read(cache);
+     * \endcode
+     */
+    class Binary
+    {
+    public:
+        /**
+         * \brief Writes root and all of its children to output.
+         */
+        static void write(OStream& output, const Node* root);
+
+        /**
+         * \brief Replaces the contents of dest with the binary form of root.
+         */
+        static void toString(String& dest, const Node* root);
+
+        /**
+         * \brief Builds a new tree from a binary document.
+         * \return A new node that the caller is responsible for deleting.
+         * \throws Exception if the data is not a complete binary document.
+         */
+        static Node* read(std::string_view data);
+
+        /**
+         * \brief Reads the rest of the input and builds a new tree from it.
+         * \see read(std::string_view)
+         */
+        static Node* read(IStream& input);
+    };
+
+}  // namespace Rt2::Xml
@@ -0,0 +1,278 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/BufferReader.h"
+#include <algorithm>
+#include "Utils/Char.h"
+#include "Utils/Exception.h"
+#include "Xml/SpecialChar.h"
+
+namespace Rt2::Xml
+{
+    inline bool isNameCharacter(const int ch)
+    {
+        return isLetter(ch) || isDecimal(ch) || ch == '_' || ch == ':' || ch == '-';
+    }
+
+    BufferReader::BufferReader(const std::string_view buffer,
+                               DecodeStorage*         storage) :
+        _buffer(buffer),
+        _storage(storage)
+    {
+    }
+
+    template <typename... Args>
+    void BufferReader::error(Args&&... args) const
+    {
+        throw Exception("line ", line(), ": ", std::forward<Args>(args)...);
+    }
+
+    size_t BufferReader::line() const
+    {
+        // Only used for errors, so it is
+        // computed on demand.
+        const size_t end = std::min(_pos, _buffer.size());
+        return 1 + (size_t)std::count(_buffer.begin(), _buffer.begin() + (ptrdiff_t)end, '\n');
+    }
+
+    char BufferReader::peek(const size_t offs) const
+    {
+        if (_pos + offs < _buffer.size())
+            return _buffer[_pos + offs];
+        return 0;
+    }
+
+    void BufferReader::skipWhiteSpace()
+    {
+        while (_pos < _buffer.size() && isWhiteSpace(_buffer[_pos]))
+            ++_pos;
+    }
+
+    void BufferReader::skipUntil(const std::string_view marker)
+    {
+        const size_t end = _buffer.find(marker, _pos);
+        if (end == std::string_view::npos)
+            error("unexpected end of file, expected '", marker, "'");
+        _pos = end + marker.size();
+    }
+
+    std::string_view BufferReader::scanName()
+    {
+        const size_t start = _pos;
+        if (!isLetter(peek()))
+            error("expected an identifier");
+
+        while (_pos < _buffer.size() && isNameCharacter(_buffer[_pos]))
+            ++_pos;
+        return _buffer.substr(start, _pos - start);
+    }
+
+    std::string_view BufferReader::decode(const std::string_view value)
+    {
+        if (value.find('&') == std::string_view::npos)
+            return value;
+
+        String* dest;
+        if (_storage)
+            dest = &_storage->emplace_back();
+        else
+        {
+            // reuse the scratch strings so that their
+            // capacity carries over between events
+            if (_scratchUsed >= _scratch.size())
+                _scratch.emplace_back();
+            dest = &_scratch[_scratchUsed++];
+            dest->clear();
+        }
+
+        SpecialChar::decode(*dest, value);
+        return *dest;
+    }
+
+    std::string_view BufferReader::scanValue()
+    {
+        const char quote = peek();
+        if (!isQuote(quote))
+            error("expected the quote character '\"'");
+
+        const size_t start = ++_pos;
+        const size_t end   = _buffer.find(quote, start);
+        if (end == std::string_view::npos)
+            error("unexpected end of file");
+
+        _pos = end + 1;
+        return decode(_buffer.substr(start, end - start));
+    }
+
+    ReadEvent BufferReader::scanStartTag()
+    {
+        ++_pos;  // <
+        _name = scanName();
+
+        for (;;)
+        {
+            skipWhiteSpace();
+
+            const char ch = peek();
+            if (ch == '>')
+            {
+                ++_pos;
+                break;
+            }
+
+            if (ch == '/')
+            {
+                if (peek(1) != '>')
+                    error("expected the '>' character");
+                _pos += 2;
+                _closePending = true;
+                break;
+            }
+
+            if (ch == 0)
+                error("unexpected end of file");
+
+            const std::string_view key = scanName();
+            skipWhiteSpace();
+            if (peek() != '=')
+                error("expected an equals sign");
+            ++_pos;
+            skipWhiteSpace();
+
+            for (const auto& [k, v] : _attributes)
+            {
+                if (k == key)
+                    error(_name, " duplicate attribute ", key);
+            }
+
+            _attributes.push_back({key, scanValue()});
+        }
+
+        _open.push_back(_name);
+        return READ_START_TAG;
+    }
+
+    ReadEvent BufferReader::scanEndTag()
+    {
+        _pos += 2;  // </
+        _name = scanName();
+        skipWhiteSpace();
+
+        if (peek() != '>')
+            error("expected the '>' character");
+        ++_pos;
+
+        if (_open.empty())
+            error("unexpected closing tag '", _name, "'");
+
+        if (_open.back() != _name)
+        {
+            error("closing tag mis-match between '",
+                  _open.back(),
+                  "' and '",
+                  _name,
+                  '\'');
+        }
+
+        _open.pop_back();
+        return READ_END_TAG;
+    }
+
+    ReadEvent BufferReader::next()
+    {
+        _attributes.clear();
+        _scratchUsed = 0;
+
+        if (_closePending)
+        {
+            // the name is still the same
+            // from the start tag
+            _closePending = false;
+            _open.pop_back();
+            return READ_END_TAG;
+        }
+
+        while (_pos < _buffer.size())
+        {
+            if (_buffer[_pos] == '<')
+            {
+                const char ch = peek(1);
+                if (ch == '!')
+                {
+                    if (_buffer.substr(_pos, 4) == "<!--")
+                        skipUntil("-->");
+                    else
+                        skipUntil(">");
+                }
+                else if (ch == '?')
+                    skipUntil("?>");
+                else if (ch == '/')
+                    return scanEndTag();
+                else
+                    return scanStartTag();
+            }
+            else
+            {
+                size_t end = _buffer.find('<', _pos);
+                if (end == std::string_view::npos)
+                    end = _buffer.size();
+
+                const std::string_view content = _buffer.substr(_pos, end - _pos);
+
+                const bool onlyWhiteSpace = std::all_of(
+                    content.begin(),
+                    content.end(),
+                    [](const char ch)
+                    { return isWhiteSpace(ch); });
+
+                if (!onlyWhiteSpace)
+                {
+                    if (_open.empty())
+                        error("text found outside of an element");
+
+                    _text = decode(content);
+                    _pos  = end;
+                    return READ_TEXT;
+                }
+                _pos = end;
+            }
+        }
+
+        if (!_open.empty())
+            error("unexpected end of file, '", _open.back(), "' was not closed");
+        return READ_EOF;
+    }
+
+    void BufferReader::skipElement()
+    {
+        const size_t depth = _open.size();
+        if (depth == 0)
+            return;
+
+        ReadEvent ev;
+        while ((ev = next()) != READ_EOF)
+        {
+            if (ev == READ_END_TAG && _open.size() < depth)
+                break;
+        }
+    }
+
+}  // namespace Rt2::Xml
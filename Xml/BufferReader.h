@@ -0,0 +1,166 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <deque>
+#include <string_view>
+#include <vector>
+#include "Utils/String.h"
+
+namespace Rt2::Xml
+{
+    enum ReadEvent
+    {
+        READ_EOF = 0,
+        READ_START_TAG,
+        READ_END_TAG,
+        READ_TEXT,
+    };
+
+    /**
+     * \brief A key-value pair that refers to memory owned by someone else.
+     */
+    struct ViewAttribute
+    {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    using ViewAttributeArray = std::vector<ViewAttribute>;
+
+    /**
+     * \brief Provides storage for values that had to be decoded.
+     * A deque is used so that growing it does not move the existing strings.
+     */
+    using DecodeStorage = std::deque<String>;
+
+    /**
+     * \brief Is a pull parser that reads XML directly from a memory buffer.
+     *
+     * Each call to next advances to the next start tag, end tag or block of
+     * text. Names, attributes and text are views into the buffer, so nothing
+     * is copied unless an attribute value or text has to be entity-decoded.
+     * A self-closing tag is reported as a start tag followed by an end tag.
+     *
+     * It accepts the same input as File. Text that only contains
+     * white space is skipped. The xml declaration and comments are ignored.
+     * Any syntax error throws an exception.
+     */
+    class BufferReader
+    {
+    private:
+        std::string_view              _buffer;
+        size_t                        _pos{0};
+        std::string_view              _name;
+        std::string_view              _text;
+        ViewAttributeArray            _attributes;
+        std::vector<std::string_view> _open;
+        DecodeStorage*                _storage{nullptr};
+        DecodeStorage                 _scratch;
+        size_t                        _scratchUsed{0};
+        bool                          _closePending{false};
+
+        char peek(size_t offs = 0) const;
+
+        void skipWhiteSpace();
+
+        void skipUntil(std::string_view marker);
+
+        std::string_view scanName();
+
+        std::string_view scanValue();
+
+        std::string_view decode(std::string_view value);
+
+        ReadEvent scanStartTag();
+
+        ReadEvent scanEndTag();
+
+        size_t line() const;
+
+        template <typename... Args>
+        [[noreturn]] void error(Args&&... args) const;
+
+    public:
+        /**
+         * \param buffer The memory to read. It must stay valid as long
+         * as any view handed out by this reader is in use.
+         * \param storage Optional storage for decoded values. If supplied,
+         * decoded values stay valid for the storage's lifetime, otherwise they
+         * are only valid until the next call to next.
+         */
+        explicit BufferReader(std::string_view buffer,
+                              DecodeStorage*   storage = nullptr);
+
+        /**
+         * \brief Advances to the next event.
+         * \return READ_EOF when the end of the buffer has been reached.
+         */
+        ReadEvent next();
+
+        /**
+         * \brief Skips the rest of the element that was last started, including all of its children.
+         * The element's end tag is consumed, so the next event comes after it.
+         */
+        void skipElement();
+
+        /**
+         * \return The tag name for READ_START_TAG and READ_END_TAG events.
+         */
+        std::string_view name() const;
+
+        /**
+         * \return The content for READ_TEXT events.
+         */
+        std::string_view text() const;
+
+        /**
+         * \return The attributes for a READ_START_TAG event.
+         */
+        const ViewAttributeArray& attributes() const;
+
+        /**
+         * \return The number of elements that are currently open.
+         */
+        size_t depth() const;
+    };
+
+    inline std::string_view BufferReader::name() const
+    {
+        return _name;
+    }
+
+    inline std::string_view BufferReader::text() const
+    {
+        return _text;
+    }
+
+    inline const ViewAttributeArray& BufferReader::attributes() const
+    {
+        return _attributes;
+    }
+
+    inline size_t BufferReader::depth() const
+    {
+        return _open.size();
+    }
+
+}  // namespace Rt2::Xml
@@ -0,0 +1,407 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/Diff.h"
+#include <algorithm>
+#include <unordered_map>
+#include "Utils/Exception.h"
+
+namespace Rt2::Xml
+{
+    constexpr size_t NoMatch = (size_t)-1;
+
+    static DiffEdit& addEdit(DiffScript& dest, const DiffOperation op, const NodePath& path)
+    {
+        DiffEdit& edit = dest.emplace_back();
+        edit.op        = op;
+        edit.path      = path;
+        return edit;
+    }
+
+    /**
+     * \brief Counts the live keys below a key in O(log n).
+     * The keys it can hold are fixed when it is built.
+     */
+    class PositionTree
+    {
+    private:
+        std::vector<int64_t>   _keys;
+        std::vector<ptrdiff_t> _tree;
+
+        size_t slot(const int64_t key) const
+        {
+            return (size_t)(std::lower_bound(_keys.begin(), _keys.end(), key) - _keys.begin());
+        }
+
+    public:
+        explicit PositionTree(std::vector<int64_t> keys) :
+            _keys(std::move(keys))
+        {
+            std::sort(_keys.begin(), _keys.end());
+            _keys.erase(std::unique(_keys.begin(), _keys.end()), _keys.end());
+            _tree.assign(_keys.size() + 1, 0);
+        }
+
+        void add(const int64_t key, const ptrdiff_t delta)
+        {
+            for (size_t i = slot(key) + 1; i < _tree.size(); i += i & (~i + 1))
+                _tree[i] += delta;
+        }
+
+        size_t below(const int64_t key) const
+        {
+            ptrdiff_t sum = 0;
+            for (size_t i = slot(key); i > 0; i -= i & (~i + 1))
+                sum += _tree[i];
+            return (size_t)sum;
+        }
+    };
+
+    Diff::Diff(String idAttribute) :
+        _idAttribute(std::move(idAttribute))
+    {
+    }
+
+    bool Diff::hasId(const Node* node) const
+    {
+        return !_idAttribute.empty() && node->contains(_idAttribute);
+    }
+
+    void Diff::compareNode(const Node*     a,
+                           const Node*     b,
+                           const NodePath& path,
+                           DiffScript&     dest) const
+    {
+        for (const auto& [key, value] : b->attributes())
+        {
+            if (const auto it = a->attributes().find(key);
+                it == a->attributes().end() || it->second != value)
+            {
+                DiffEdit& edit = addEdit(dest, DIFF_SET_ATTRIBUTE, path);
+                edit.key       = key;
+                edit.value     = value;
+            }
+        }
+
+        for (const auto& [key, value] : a->attributes())
+        {
+            if (!b->contains(key))
+                addEdit(dest, DIFF_REMOVE_ATTRIBUTE, path).key = key;
+        }
+
+        if (a->text() != b->text())
+            addEdit(dest, DIFF_TEXT, path).value = b->text();
+    }
+
+    void Diff::compareChildren(const Node*          a,
+                               const Node*          b,
+                               const NodePath&      path,
+                               DiffScript&          dest,
+                               std::vector<size_t>& pairs) const
+    {
+        const NodeArray& from = a->children();
+        const NodeArray& to   = b->children();
+
+        std::vector<size_t> matched(from.size(), NoMatch);
+        pairs.assign(to.size(), NoMatch);
+
+        // Each pass pairs the children the previous ones left over. The
+        // candidates are pushed in reverse so the back is the first one
+        // in document order.
+        if (!_idAttribute.empty())
+        {
+            const auto makeKey = [this](const Node* node)
+            {
+                String key = node->name();
+                key.push_back('\n');
+                key.append(node->attribute(_idAttribute));
+                return key;
+            };
+
+            std::unordered_map<String, std::vector<size_t>> byId;
+            for (size_t i = from.size(); i > 0; --i)
+            {
+                if (hasId(from[i - 1]))
+                    byId[makeKey(from[i - 1])].push_back(i - 1);
+            }
+
+            for (size_t j = 0; j < to.size() && !byId.empty(); ++j)
+            {
+                if (!hasId(to[j]))
+                    continue;
+
+                if (const auto it = byId.find(makeKey(to[j]));
+                    it != byId.end() && !it->second.empty())
+                {
+                    matched[it->second.back()] = j;
+                    pairs[j]                   = it->second.back();
+                    it->second.pop_back();
+                }
+            }
+        }
+
+        std::unordered_map<uint64_t, std::vector<size_t>> byHash;
+        for (size_t i = from.size(); i > 0; --i)
+        {
+            if (matched[i - 1] == NoMatch)
+                byHash[from[i - 1]->hash()].push_back(i - 1);
+        }
+
+        for (size_t j = 0; j < to.size(); ++j)
+        {
+            if (pairs[j] != NoMatch)
+                continue;
+
+            if (const auto it = byHash.find(to[j]->hash());
+                it != byHash.end() && !it->second.empty())
+            {
+                matched[it->second.back()] = j;
+                pairs[j]                   = it->second.back();
+                it->second.pop_back();
+            }
+        }
+
+        std::unordered_map<std::string_view, std::vector<size_t>> byName;
+        for (size_t i = from.size(); i > 0; --i)
+        {
+            if (matched[i - 1] == NoMatch && !hasId(from[i - 1]))
+                byName[from[i - 1]->name()].push_back(i - 1);
+        }
+
+        for (size_t j = 0; j < to.size(); ++j)
+        {
+            if (pairs[j] != NoMatch || hasId(to[j]))
+                continue;
+
+            if (const auto it = byName.find(to[j]->name());
+                it != byName.end() && !it->second.empty())
+            {
+                matched[it->second.back()] = j;
+                pairs[j]                   = it->second.back();
+                it->second.pop_back();
+            }
+        }
+
+        // Delete from the back so the indices of
+        // the remaining children stay the same.
+        for (size_t i = from.size(); i > 0; --i)
+        {
+            if (matched[i - 1] == NoMatch)
+                addEdit(dest, DIFF_DELETE, path).index = i - 1;
+        }
+
+        // The order of the kept children in terms of their target
+        // positions. The longest increasing run of it stays where it
+        // is and everything else is moved.
+        std::vector<size_t> order;
+        order.reserve(from.size());
+        for (const size_t j : matched)
+        {
+            if (j != NoMatch)
+                order.push_back(j);
+        }
+
+        std::vector<size_t> tails, tailAt, prev(order.size(), NoMatch);
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            const size_t len = (size_t)(std::lower_bound(tails.begin(), tails.end(), order[k]) - tails.begin());
+            if (len == tails.size())
+            {
+                tails.push_back(order[k]);
+                tailAt.push_back(k);
+            }
+            else
+            {
+                tails[len]  = order[k];
+                tailAt[len] = k;
+            }
+            if (len > 0)
+                prev[k] = tailAt[len - 1];
+        }
+
+        std::vector<bool> inPlace(to.size(), false);
+        for (size_t k = tailAt.empty() ? NoMatch : tailAt.back(); k != NoMatch; k = prev[k])
+            inPlace[order[k]] = true;
+
+        if (tails.size() == to.size())
+            return;
+
+        // Walk the target positions in order, putting each child that
+        // is not in place directly after the one that precedes it.
+        //
+        // Positions come from sort keys. A kept child starts at its index
+        // times stride, and a placed child takes the key right above the
+        // child before it, so a run of placed children fits between two
+        // of the starting keys. The index of a child is then the number
+        // of live keys below its own.
+        const int64_t stride = (int64_t)to.size() + 2;
+
+        std::vector<int64_t> start(to.size(), 0), placed(to.size(), 0), keys;
+        keys.reserve(order.size() + to.size());
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            start[order[k]] = (int64_t)k * stride;
+            keys.push_back(start[order[k]]);
+        }
+
+        int64_t previous = -stride;
+        for (size_t j = 0; j < to.size(); ++j)
+        {
+            if (!inPlace[j])
+            {
+                placed[j] = previous + 1;
+                keys.push_back(placed[j]);
+            }
+            previous = inPlace[j] ? start[j] : placed[j];
+        }
+
+        PositionTree positions(std::move(keys));
+        for (size_t k = 0; k < order.size(); ++k)
+            positions.add((int64_t)k * stride, 1);
+
+        for (size_t j = 0; j < to.size(); ++j)
+        {
+            if (inPlace[j])
+                continue;
+
+            if (pairs[j] == NoMatch)
+            {
+                const size_t index = positions.below(placed[j]);
+                positions.add(placed[j], 1);
+
+                DiffEdit& edit = addEdit(dest, DIFF_INSERT, path);
+                edit.index     = index;
+                edit.node      = to[j];
+            }
+            else
+            {
+                const size_t source = positions.below(start[j]);
+                positions.add(start[j], -1);
+
+                const size_t index = positions.below(placed[j]);
+                positions.add(placed[j], 1);
+                if (index != source)
+                {
+                    DiffEdit& edit = addEdit(dest, DIFF_MOVE, path);
+                    edit.index     = index;
+                    edit.from      = source;
+                }
+            }
+        }
+    }
+
+    void Diff::compare(const Node* from, const Node* to, DiffScript& dest) const
+    {
+        if (!from || !to)
+            return;
+
+        if (from->name() != to->name())
+            throw Exception("the root nodes '", from->name(), "' and '", to->name(), "' must have the same name");
+
+        struct Work
+        {
+            const Node* a;
+            const Node* b;
+            NodePath    path;
+        };
+
+        std::vector<Work>   stack;
+        std::vector<size_t> pairs;
+        stack.push_back({from, to, {}});
+
+        while (!stack.empty())
+        {
+            const Work work = std::move(stack.back());
+            stack.pop_back();
+
+            if (work.a->hash() == work.b->hash())
+                continue;
+
+            compareNode(work.a, work.b, work.path, dest);
+            compareChildren(work.a, work.b, work.path, dest, pairs);
+
+            // After the edits above the children of a are in the
+            // order of b, so paired children use b's positions.
+            // They are pushed in reverse to be compared in order.
+            for (size_t j = pairs.size(); j > 0; --j)
+            {
+                if (pairs[j - 1] == NoMatch)
+                    continue;
+
+                const Node* a = work.a->at(pairs[j - 1]);
+                const Node* b = work.b->at(j - 1);
+                if (a->hash() == b->hash())
+                    continue;
+
+                NodePath path = work.path;
+                path.push_back(j - 1);
+                stack.push_back({a, b, std::move(path)});
+            }
+        }
+    }
+
+    void Diff::apply(Node* root, const DiffScript& script)
+    {
+        if (!root)
+            return;
+
+        for (const DiffEdit& edit : script)
+        {
+            Node* node = root;
+            for (const size_t idx : edit.path)
+            {
+                node = node->at(idx);
+                if (!node)
+                    throw Exception("the edit path does not exist in the tree");
+            }
+
+            switch (edit.op)
+            {
+            case DIFF_INSERT:
+                if (!edit.node)
+                    throw Exception("an insert edit is missing its node");
+                node->insertChild(edit.index, edit.node->clone());
+                break;
+            case DIFF_DELETE:
+                if (edit.index >= node->size())
+                    throw Exception("the deleted child ", edit.index, " does not exist");
+                node->removeChild(edit.index);
+                break;
+            case DIFF_MOVE:
+                if (Node* child = node->detachChild(edit.from))
+                    node->insertChild(edit.index, child);
+                else
+                    throw Exception("the moved child ", edit.from, " does not exist");
+                break;
+            case DIFF_SET_ATTRIBUTE:
+                node->setAttribute(edit.key, edit.value);
+                break;
+            case DIFF_REMOVE_ATTRIBUTE:
+                node->removeAttribute(edit.key);
+                break;
+            case DIFF_TEXT:
+                node->text(edit.value);
+                break;
+            }
+        }
+    }
+
+}  // namespace Rt2::Xml
@@ -0,0 +1,121 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <vector>
+#include "Utils/String.h"
+#include "Xml/Node.h"
+
+namespace Rt2::Xml
+{
+    enum DiffOperation
+    {
+        DIFF_INSERT = 0,        // insert a copy of node at path[index]
+        DIFF_DELETE,            // delete the child path[index]
+        DIFF_MOVE,              // move the child path[from] to path[index]
+        DIFF_SET_ATTRIBUTE,     // set key to value on the node at path
+        DIFF_REMOVE_ATTRIBUTE,  // remove key from the node at path
+        DIFF_TEXT,              // set the text of the node at path to value
+    };
+
+    /**
+     * \brief A single step of an edit script.
+     *
+     * Paths and indices refer to the tree as it is when the edit is applied,
+     * after all of the edits before it. A move removes the child at from
+     * first, so index is a position in the list without it.
+     */
+    struct DiffEdit
+    {
+        DiffOperation op{DIFF_TEXT};
+        NodePath      path;
+        size_t        index{0};
+        size_t        from{0};
+        String        key;
+        String        value;
+        const Node*   node{nullptr};
+    };
+
+    using DiffScript = std::vector<DiffEdit>;
+
+    /**
+     * \brief Computes the edits that turn one Node tree into another.
+     *
+     * Subtrees with equal structural hashes are skipped without being
+     * visited, so the cost mostly depends on the size of the changes.
+     * On each level the children are paired up, first by name and id
+     * attribute, then by identical hashes and finally by name in
+     * document order. Children that cannot be paired are deleted or
+     * inserted, and paired children are only moved if they are not part
+     * of the longest run that is already in order.
+     *
+     * Inserted nodes refer to the target tree, so the script is only
+     * valid for as long as that tree is. To send a script elsewhere,
+     * write each inserted node with the Writer.
+     *
+     * \code{.cpp}
+     * Xml::DiffScript script;
+     * Xml::Diff("id").compare(before.tree(), after.tree(), script);
+     * Xml::Diff::apply(copy.tree(), script);
+     * \endcode
+     */
+    class Diff
+    {
+    private:
+        String _idAttribute;
+
+        bool hasId(const Node* node) const;
+
+        void compareNode(const Node*     a,
+                         const Node*     b,
+                         const NodePath& path,
+                         DiffScript&     dest) const;
+
+        void compareChildren(const Node*          a,
+                             const Node*          b,
+                             const NodePath&      path,
+                             DiffScript&          dest,
+                             std::vector<size_t>& pairs) const;
+
+    public:
+        /**
+         * \param idAttribute The attribute that identifies an element among
+         * its siblings. Elements that have it are only paired with elements
+         * of the same name and id. Use an empty string to disable it.
+         */
+        explicit Diff(String idAttribute = "id");
+
+        /**
+         * \brief Appends the edits that turn from into to onto dest.
+         * \throws Exception if the two nodes do not have the same name,
+         * since the root itself can not be replaced.
+         */
+        void compare(const Node* from, const Node* to, DiffScript& dest) const;
+
+        /**
+         * \brief Applies a script to root, which should be equal to the
+         * tree the script was computed from.
+         * \throws Exception if an edit refers to a node that does not exist.
+         */
+        static void apply(Node* root, const DiffScript& script);
+    };
+
+}  // namespace Rt2::Xml
@@ -70,6 +70,10 @@ namespace Rt2::Xml
 
     void File::errorMessageImpl(String& dest, const String& message)
     {
+        // the nodes on the stack are about to
+        // be deleted, some of them are indexed
+        _types.clear();
+
         OutputStringStream oss;
         oss << message << std::endl;
         while (_stack.size() > 1)
@@ -81,16 +85,75 @@ namespace Rt2::Xml
         dest = oss.str();
     }
 
-    Node* File::createTag(const String& name)
+    Node* File::createTag(String name)
     {
         if (++_tagCount > _maxTags)
             error("maximum tag limit exceeded");
 
-        Node* node = new Node(name);
+        Node* node = new Node(std::move(name));
         _stack.push(node);
+
+        // Index on creation rather than in reduceRule, so that
+        // the nodes are recorded in document order. The code is
+        // assigned again when the node is reduced.
+        if (_indexTypes && !_filter.empty())
+        {
+            if (const auto it = _filter.find(node->name());
+                it != _filter.end())
+                _types[it->second].push_back(node);
+        }
         return node;
     }
 
+    void File::unindex(const Node* node)
+    {
+        // Everything that was created after the node is
+        // part of its subtree, so they are always at the
+        // end of each list.
+        for (auto& [code, nodes] : _types)
+        {
+            while (!nodes.empty())
+            {
+                const Node* cur = nodes.back();
+                while (cur && cur != node)
+                    cur = cur->parent();
+
+                if (!cur)
+                    break;
+                nodes.pop_back();
+            }
+        }
+    }
+
+    const NodeArray& File::nodesOf(const int64_t code) const
+    {
+        static const NodeArray Empty;
+
+        if (const auto it = _types.find(code);
+            it != _types.end())
+            return it->second;
+        return Empty;
+    }
+
+    MemoryUsage File::memoryUsage() const
+    {
+        MemoryUsage usage;
+        if (_root)
+            usage = _root->memoryUsage();
+
+        usage.indexBytes += heapBytes(_types);
+        for (const auto& [code, nodes] : _types)
+            usage.indexBytes += heapBytes(nodes);
+
+        usage.tableBytes += heapBytes(_filter);
+        for (const auto& [name, code] : _filter)
+            usage.tableBytes += heapBytes(name);
+
+        if (_scanner)
+            usage.tableBytes += ((const Scanner*)_scanner)->memoryUsage();
+        return usage;
+    }
+
     Node& File::top()
     {
         if (_stack.empty())
@@ -112,6 +175,10 @@ namespace Rt2::Xml
 
     Node* File::detachRoot()
     {
+        // the new owner can change or delete the
+        // tree, so the index would be left dangling
+        _types.clear();
+
         _isAttached      = false;
         Node* detachment = _root;
         _root            = nullptr;
@@ -145,7 +212,11 @@ namespace Rt2::Xml
                     a->addChild(b);
                 }
                 else
+                {
+                    if (_indexTypes && b->hasChildren())
+                        unindex(b);
                     delete b;
+                }
             }
         }
     }
@@ -156,6 +227,9 @@ namespace Rt2::Xml
         {
             const Node* b = _stack.top();
             _stack.pop();
+
+            if (_indexTypes)
+                unindex(b);
             delete b;
         }
     }
@@ -200,13 +274,13 @@ namespace Rt2::Xml
         String identifier;
         _scanner->string(identifier, token(0).index());
 
-        if (node.contains(identifier))
-            error(node.name(), " duplicate attribute ", identifier);
-
         String value;
         _scanner->string(value, token(2).index());
 
-        node.insert(identifier, value);
+        // insert only moves from its arguments on success,
+        // so identifier is still valid in the error message
+        if (!node.insert(std::move(identifier), std::move(value)))
+            error(node.name(), " duplicate attribute ", identifier);
         advanceCursor(3);
     }
 
@@ -262,7 +336,7 @@ namespace Rt2::Xml
 
         advanceCursor(2);
 
-        createTag(value);
+        createTag(std::move(value));
 
         ruleAttributeList(guard);
 
@@ -298,7 +372,7 @@ namespace Rt2::Xml
         String content;
 
         auto* scn = (Scanner*)_scanner;
-        scn->getCode(content, t0.index());
+        scn->takeCode(content, t0.index());
 
         if (content.empty())
             error("unexpected empty content token");
@@ -306,7 +380,7 @@ namespace Rt2::Xml
         top().text(content);
 
         Node* node = createTag("_text_node");
-        node->text(content);
+        node->text(std::move(content));
         reduceRule();
 
         advanceCursor();
@@ -397,6 +471,7 @@ namespace Rt2::Xml
         // to the scanner
         _cursor   = 0;
         _tagCount = 1;
+        _types.clear();
         _scanner->attach(&input, PathUtil(_file));
         _stack.push(_root);
 
@@ -452,19 +527,13 @@ namespace Rt2::Xml
         if (!root)
             return nullptr;
 
-        String ret;
-        Writer::toString(ret, root);
-
-        if (!ret.empty())
-        {
-            InputStringStream stream(ret);
-
-            File fp(filter, filterSize);
-            fp.read(stream);
+        TypeFilterMap types;
+        makeTypeFilter(types, filter, filterSize);
 
-            return fp.detachRoot();
-        }
-        return nullptr;
+        Node* base = new Node();
+        if (Node* copy = root->clone(types))
+            base->addChild(copy);
+        return base;
     }
 
     Node* File::detachRead(const TypeFilter* filter,
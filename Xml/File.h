@@ -21,6 +21,7 @@
 */
 #pragma once
 #include <stack>
+#include <unordered_map>
 #include "ParserBase/ParserBase.h"
 #include "ParserBase/StackGuard.h"
 #include "Utils/Definitions.h"
@@ -81,6 +82,11 @@ namespace Rt2::Xml
      */
     using NodeStack = std::stack<Node*>;
 
+    /**
+     * \brief Maps a filter type code to every node of that type in document order.
+     */
+    using TypeIndex = std::unordered_map<int64_t, NodeArray>;
+
     /**
      * \brief Parser is the XML based implementation of the ParseBase base class.
      *
@@ -128,7 +134,9 @@ namespace Rt2::Xml
         Node*         _root;
         NodeStack     _stack;
         TypeFilterMap _filter;
+        TypeIndex     _types;
         bool          _isAttached{true};
+        bool          _indexTypes{false};
         const U16     _maxDepth{0};
         const U16     _maxTags{0};
         U16           _tagCount{0};
@@ -163,12 +171,14 @@ namespace Rt2::Xml
 
         void ruleObjectList(StackGuard& guard);
 
-        Node* createTag(const String& name);
+        Node* createTag(String name);
 
         void reduceRule();
 
         void dropRule();
 
+        void unindex(const Node* node);
+
         Node& top();
 
         void errorMessageImpl(String& dest, const String& message) override;
@@ -201,6 +211,27 @@ namespace Rt2::Xml
          */
         void applyFilter(const TypeFilter* filter, size_t filterSize);
 
+        /**
+         * \brief Enables building a TypeIndex during the next read.
+         *
+         * When enabled and a filter has been applied, every node that the
+         * filter accepts is recorded under its type code as it is parsed.
+         * It is disabled by default.
+         */
+        void setIndexTypes(bool value);
+
+        /**
+         * \brief Provides every node of the supplied type code in document order.
+         *
+         * Requires setIndexTypes(true) before the read. The nodes belong to the
+         * tree, so the array is only valid while the tree is. The index is not
+         * updated by structural edits; removing or deleting nodes from the tree
+         * leaves it holding dangling pointers. detachRoot clears it.
+         * \param code The filter type code to look up.
+         * \return The nodes with the type code, or an empty array.
+         */
+        const NodeArray& nodesOf(int64_t code) const;
+
         /**
          * \brief Provides access to the 'root' of the node tree. Not the actual
          * XML root node. Use tree()->firstChildOf(<xml-root-node>) or root(<xml-root-node>) to gain access
@@ -208,6 +239,13 @@ namespace Rt2::Xml
          */
         Node* tree() const;
 
+        /**
+         * \brief Measures the memory held by the tree, the type index, the filter
+         * and the content text the scanner still holds from the last read.
+         * \see MemoryUsage
+         */
+        MemoryUsage memoryUsage() const;
+
         Node* root(int64_t code) const;
 
         Node* root(const char* name) const;
@@ -216,6 +254,21 @@ namespace Rt2::Xml
 
         U16 tagCount() const;
 
+        /**
+         * \brief Creates a deep copy of the supplied node.
+         *
+         * The names, attributes, text and children are copied directly
+         * from the source tree. If a filter is supplied, it is applied the
+         * same way it is applied during a read; any node not found in the filter
+         * is dropped along with its children, and every kept node is given its
+         * type code from the filter. Without a filter the source type codes are kept.
+         *
+         * \param root The node to copy.
+         * \param filter Constant array of tag-name to tag-id structures.
+         * \param filterSize The total size of the constant array.
+         * \return A new base node that contains the copy as its first child.
+         * The caller is responsible for deleting it.
+         */
         static Node* constructClone(const Node*       root,
                                     const TypeFilter* filter,
                                     size_t            filterSize);
@@ -251,4 +304,9 @@ namespace Rt2::Xml
         return _tagCount;
     }
 
+    inline void File::setIndexTypes(const bool value)
+    {
+        _indexTypes = value;
+    }
+
 }  // namespace Rt2::Xml
@@ -0,0 +1,96 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Utils/String.h"
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief A breakdown of the memory held by a node tree, in bytes.
+     *
+     * The numbers are what the containers request from the allocator, using
+     * their capacity rather than their size. Allocator headers and padding are
+     * not included, so the real cost is somewhat higher. Strings that fit in
+     * the small string buffer count as part of the structure that holds them.
+     */
+    struct MemoryUsage
+    {
+        size_t nodes{0};           // the number of nodes
+        size_t nodeBytes{0};       // the Node structs themselves
+        size_t nameBytes{0};       // heap storage of node names
+        size_t textBytes{0};       // heap storage of node text
+        size_t attributeBytes{0};  // attribute maps with their keys and values
+        size_t childBytes{0};      // child arrays
+        size_t indexBytes{0};      // child and type indices
+        size_t tableBytes{0};      // filters and string tables left over from parsing
+
+        size_t total() const
+        {
+            return nodeBytes + nameBytes + textBytes + attributeBytes +
+                   childBytes + indexBytes + tableBytes;
+        }
+
+        MemoryUsage& operator+=(const MemoryUsage& rhs)
+        {
+            nodes += rhs.nodes;
+            nodeBytes += rhs.nodeBytes;
+            nameBytes += rhs.nameBytes;
+            textBytes += rhs.textBytes;
+            attributeBytes += rhs.attributeBytes;
+            childBytes += rhs.childBytes;
+            indexBytes += rhs.indexBytes;
+            tableBytes += rhs.tableBytes;
+            return *this;
+        }
+    };
+
+    /**
+     * \return The bytes a string holds outside of its own struct.
+     */
+    inline size_t heapBytes(const String& str)
+    {
+        static const size_t inPlace = String().capacity();
+        return str.capacity() > inPlace ? str.capacity() + 1 : 0;
+    }
+
+    template <typename T>
+    size_t heapBytes(const std::vector<T>& arr)
+    {
+        return arr.capacity() * sizeof(T);
+    }
+
+    /**
+     * \return The bytes an unordered container holds for its buckets and
+     * entries, not counting any heap storage of the entries themselves.
+     */
+    template <typename Map>
+    size_t heapBytes(const Map& map)
+    {
+        // Each entry is a list node with a next pointer and,
+        // for most key types, the cached hash of its key.
+        constexpr size_t entry = sizeof(typename Map::value_type) + sizeof(void*) + sizeof(size_t);
+        return map.bucket_count() * sizeof(void*) + map.size() * entry;
+    }
+
+}  // namespace Rt2::Xml
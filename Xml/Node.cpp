@@ -21,15 +21,33 @@
 */
 #include "Xml/Node.h"
 #include <algorithm>
+#include <string_view>
 #include <utility>
 #include "ParserBase/ParserBase.h"
 #include "Utils/Char.h"
 #include "Utils/Exception.h"
+#include "Xml/Number.h"
 
 namespace Rt2::Xml
 {
     using AttributeIt = AttributeMap::const_iterator;
 
+    /**
+     * \brief Maps the children of a wide node by name and by type code.
+     * Each list keeps the children in the same order as Node::children.
+     */
+    struct ChildIndex
+    {
+        std::unordered_map<std::string_view, NodeArray> byName;
+        std::unordered_map<int64_t, NodeArray>          byType;
+
+        void add(Node* child)
+        {
+            byName[child->name()].push_back(child);
+            byType[child->type()].push_back(child);
+        }
+    };
+
     Node::Node(String name, const int64_t typeCode) :
         _typeCode(typeCode),
         _name(std::move(name))
@@ -47,6 +65,32 @@ namespace Rt2::Xml
         clearChildren();
     }
 
+    const ChildIndex* Node::index() const
+    {
+        if (_children.size() < ChildIndexThreshold)
+            return nullptr;
+
+        ChildIndex* idx = _index.load(std::memory_order_acquire);
+        if (!idx)
+        {
+            auto* built = new ChildIndex();
+            for (Node* child : _children)
+                built->add(child);
+
+            // another reader may have gotten here first
+            if (_index.compare_exchange_strong(idx, built, std::memory_order_acq_rel))
+                idx = built;
+            else
+                delete built;
+        }
+        return idx;
+    }
+
+    void Node::invalidateIndex()
+    {
+        delete _index.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
     void Node::addChild(Node* child)
     {
         if (!child)
@@ -59,18 +103,104 @@ namespace Rt2::Xml
             _children.back()->_next = child;
 
         _children.push_back(child);
+
+        // keep an existing index current rather than
+        // rebuilding it on the next lookup
+        if (ChildIndex* idx = _index.load(std::memory_order_relaxed))
+            idx->add(child);
+        invalidateHash();
     }
 
-    void Node::childrenOf(const int type, NodeArray& dest) const
+    void Node::insertChild(size_t index, Node* child)
     {
-        if (!_children.empty())
+        if (!child)
+            throw Exception("invalid node supplied to node.insertChild");
+
+        if (index >= _children.size())
         {
-            for (Node* chi : _children)
+            addChild(child);
+            return;
+        }
+
+        child->_parent = this;
+        child->_next   = _children[index];
+        if (index > 0)
+            _children[index - 1]->_next = child;
+
+        _children.insert(_children.begin() + (ptrdiff_t)index, child);
+        invalidateIndex();
+        invalidateHash();
+    }
+
+    Node* Node::detachChild(const size_t index)
+    {
+        if (index >= _children.size())
+            return nullptr;
+
+        Node* child = _children[index];
+        if (index > 0)
+            _children[index - 1]->_next = child->_next;
+
+        _children.erase(_children.begin() + (ptrdiff_t)index);
+        invalidateIndex();
+        invalidateHash();
+
+        child->_parent = nullptr;
+        child->_next   = nullptr;
+        return child;
+    }
+
+    void Node::removeChild(const size_t index)
+    {
+        const Node* child = detachChild(index);
+        if (!_childrenDetached)
+            delete child;
+    }
+
+    Node* Node::clone() const
+    {
+        static const TypeFilterMap Everything;
+        return clone(Everything);
+    }
+
+    Node* Node::clone(const TypeFilterMap& filter) const
+    {
+        return copyTree<Node>(
+            this,
+            [&filter](const Node* src, Node* parent) -> Node*
             {
-                if (chi->isTypeOf(type))
-                    dest.push_back(chi);
-            }
+                int64_t code = src->_typeCode;
+                if (!filter.empty() && !findTypeCode(filter, src->_name, code))
+                    return nullptr;
+
+                Node* dst        = new Node(src->_name, code);
+                dst->_text       = src->_text;
+                dst->_attributes = src->_attributes;
+
+                if (parent)
+                    parent->addChild(dst);
+                return dst;
+            });
+    }
+
+    void Node::childrenOf(const int type, NodeArray& dest) const
+    {
+        const TypeRange range = childrenOf((int64_t)type);
+        dest.insert(dest.end(), range.begin(), range.end());
+    }
+
+    TypeRange Node::childrenOf(const int64_t type) const
+    {
+        // A wide node hands out the matching run from its index,
+        // which leaves nothing for the iterator to skip over.
+        if (const ChildIndex* idx = index())
+        {
+            if (const auto it = idx->byType.find(type);
+                it != idx->byType.end())
+                return {it->second, type};
+            return {};
         }
+        return {_children, type};
     }
 
     Node* Node::at(const size_t& idx)
@@ -89,32 +219,59 @@ namespace Rt2::Xml
         return _children.at(idx);
     }
 
-    bool Node::contains(const String& attribute) const
+    bool Node::contains(const std::string_view attribute) const
     {
         return _attributes.find(attribute) != _attributes.end();
     }
 
-    void Node::insert(const String& key, const String& v)
+    bool Node::insert(const String& key, const String& v)
+    {
+        if (!_attributes.try_emplace(key, v).second)
+            return false;
+        invalidateHash();
+        return true;
+    }
+
+    bool Node::insert(String&& key, String&& v)
     {
-        if (const AttributeIt it = _attributes.find(key);
-            it == _attributes.end())
-            _attributes.insert(std::make_pair(key, v));
-        // TODO: Warn?
+        if (!_attributes.try_emplace(std::move(key), std::move(v)).second)
+            return false;
+        invalidateHash();
+        return true;
     }
 
-    void Node::insert(const char* key, const int v)
+    void Node::setAttribute(const String& key, const String& v)
+    {
+        _attributes.insert_or_assign(key, v);
+        invalidateHash();
+    }
+
+    bool Node::removeAttribute(const std::string_view key)
+    {
+        const auto it = _attributes.find(key);
+        if (it == _attributes.end())
+            return false;
+
+        _attributes.erase(it);
+        invalidateHash();
+        return true;
+    }
+
+    bool Node::insert(const char* key, const int v)
     {
         if (key && *key)
-            insert(key, Char::toString(v));
+            return insert(key, Char::toString(v));
+        return false;
     }
 
-    void Node::insert(const char* key, const double v)
+    bool Node::insert(const char* key, const double v)
     {
         if (key && *key)
-            insert(key, Char::toString(v));
+            return insert(key, Char::toString(v));
+        return false;
     }
 
-    const String& Node::get(const String& attribute)
+    const String& Node::get(const std::string_view attribute)
     {
         if (const AttributeIt it = _attributes.find(attribute);
             it != _attributes.end())
@@ -122,7 +279,7 @@ namespace Rt2::Xml
         throw Exception("not found");
     }
 
-    const String& Node::attribute(const String& name, const String& def) const
+    const String& Node::attribute(const std::string_view name, const String& def) const
     {
         if (const AttributeIt it = _attributes.find(name);
             it != _attributes.end())
@@ -130,39 +287,42 @@ namespace Rt2::Xml
         return def;
     }
 
-    int64_t Node::integer(const String& name, const int64_t def) const
+    int64_t Node::integer(const std::string_view name, const int64_t def) const
     {
-        if (const String val = attribute(name); !val.empty())
-            return Char::toInt64(val, def);
+        if (const AttributeIt it = _attributes.find(name);
+            it != _attributes.end())
+            return toNumber<int64_t>(it->second, def);
         return def;
     }
 
-    int64_t Node::int64(const String& name, const int64_t def) const
+    int64_t Node::int64(const std::string_view name, const int64_t def) const
     {
         return integer(name, def);
     }
 
-    int32_t Node::int32(const String& name, const int32_t def) const
+    int32_t Node::int32(const std::string_view name, const int32_t def) const
     {
         return (int32_t)integer(name, (int64_t)def);
     }
 
-    int16_t Node::int16(const String& name, const int16_t def) const
+    int16_t Node::int16(const std::string_view name, const int16_t def) const
     {
         return (int16_t)integer(name, (int64_t)def);
     }
 
-    float Node::float32(const String& name, const float def) const
+    float Node::float32(const std::string_view name, const float def) const
     {
-        if (const String val = attribute(name); !val.empty())
-            return Char::toFloat(val, def);
+        if (const AttributeIt it = _attributes.find(name);
+            it != _attributes.end())
+            return toNumber<float>(it->second, def);
         return def;
     }
 
-    double Node::float64(const String& name, const double def) const
+    double Node::float64(const std::string_view name, const double def) const
     {
-        if (const String val = attribute(name); !val.empty())
-            return Char::toDouble(val, def);
+        if (const AttributeIt it = _attributes.find(name);
+            it != _attributes.end())
+            return toNumber<double>(it->second, def);
         return def;
     }
 
@@ -171,9 +331,7 @@ namespace Rt2::Xml
         if (!tagName)
             throw Exception("invalid string supplied");
 
-        return Char::equals(_name.c_str(),
-                            tagName,
-                            std::max(_name.size(), Char::length(tagName)));
+        return isTypeOf(std::string_view(tagName));
     }
 
     bool Node::hasChildren() const
@@ -193,6 +351,14 @@ namespace Rt2::Xml
         if (!str)
             throw Exception("invalid pointer");
 
+        return hasChild(std::string_view(str));
+    }
+
+    bool Node::hasChild(const std::string_view str) const
+    {
+        if (const ChildIndex* idx = index())
+            return idx->byName.find(str) != idx->byName.end();
+
         for (const Node* child : _children)
         {
             if (child->isTypeOf(str))
@@ -203,25 +369,198 @@ namespace Rt2::Xml
 
     void Node::sort(const NodeSortFunc& fnc)
     {
-        // Use stable_sort to preserve any
-        // order that is already there.
+        // Use stable_sort to preserve any order that is already
+        // there. It stays on one thread, since this comparator
+        // was never required to be safe to call concurrently.
         std::stable_sort(_children.begin(), _children.end(), fnc);
+        relinkChildren();
+    }
+
+    void Node::invalidateHash()
+    {
+        // A cached parent implies cached children, so
+        // the walk can stop at the first cleared node.
+        for (Node* node = this; node; node = node->_parent)
+        {
+            if (node->_hash.load(std::memory_order_relaxed) == 0)
+                break;
+            node->_hash.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    namespace
+    {
+        constexpr uint64_t HashSeed  = 0xCBF29CE484222325ull;
+        constexpr uint64_t HashPrime = 0x100000001B3ull;
+
+        uint64_t mixHash(uint64_t h)
+        {
+            h ^= h >> 30;
+            h *= 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 27;
+            h *= 0x94D049BB133111EBull;
+            h ^= h >> 31;
+            return h;
+        }
+
+        uint64_t hashString(const std::string_view str, uint64_t h = HashSeed)
+        {
+            for (const char ch : str)
+            {
+                h ^= (uint8_t)ch;
+                h *= HashPrime;
+            }
+            return mixHash(h ^ str.size());
+        }
+
+    }  // namespace
+
+    uint64_t Node::computeHash() const
+    {
+        // Attributes are unordered, so their hashes are summed.
+        uint64_t attributes = 0;
+        for (const auto& [key, value] : _attributes)
+            attributes += mixHash(hashString(key) * HashPrime + hashString(value));
+
+        uint64_t h = hashString(_name);
+        h          = mixHash(h ^ attributes);
+        h          = hashString(_text, h);
+        for (const Node* child : _children)
+            h = mixHash(h * HashPrime + child->_hash.load(std::memory_order_relaxed));
+
+        // zero is reserved for 'not computed'
+        return h ? h : 1;
+    }
+
+    uint64_t Node::hash() const
+    {
+        if (const uint64_t h = _hash.load(std::memory_order_relaxed))
+            return h;
+
+        // Children are hashed before their parents,
+        // and cached subtrees are not entered at all.
+        prePostOrder(
+            this,
+            [](const Node* node)
+            {
+                return node->_hash.load(std::memory_order_relaxed) ? TRAVERSE_SKIP : TRAVERSE_CONTINUE;
+            },
+            [](const Node* node)
+            {
+                if (!node->_hash.load(std::memory_order_relaxed))
+                    node->_hash.store(node->computeHash(), std::memory_order_relaxed);
+            });
+        return _hash.load(std::memory_order_relaxed);
+    }
+
+    MemoryUsage Node::memoryUsage() const
+    {
+        MemoryUsage usage;
+        preOrder(this,
+                 [&usage](const Node* node)
+                 {
+                     usage.nodes++;
+                     usage.nodeBytes += sizeof(Node);
+                     usage.nameBytes += heapBytes(node->_name);
+                     usage.textBytes += heapBytes(node->_text);
+                     usage.childBytes += heapBytes(node->_children);
+
+                     usage.attributeBytes += heapBytes(node->_attributes);
+                     for (const auto& [key, value] : node->_attributes)
+                         usage.attributeBytes += heapBytes(key) + heapBytes(value);
+
+                     if (const ChildIndex* idx = node->_index.load(std::memory_order_acquire))
+                     {
+                         usage.indexBytes += sizeof(ChildIndex);
+                         usage.indexBytes += heapBytes(idx->byName) + heapBytes(idx->byType);
+                         for (const auto& [name, arr] : idx->byName)
+                             usage.indexBytes += heapBytes(arr);
+                         for (const auto& [code, arr] : idx->byType)
+                             usage.indexBytes += heapBytes(arr);
+                     }
+                 });
+        return usage;
+    }
+
+    bool Node::isSameAs(const Node* other) const
+    {
+        return other && (other == this || hash() == other->hash());
+    }
+
+    void Node::changes(const Node* a, const Node* b, NodePairArray& dest)
+    {
+        if (!a || !b)
+            return;
+
+        NodePairArray stack;
+        stack.emplace_back(a, b);
+
+        while (!stack.empty())
+        {
+            const auto [l, r] = stack.back();
+            stack.pop_back();
+
+            if (l->hash() == r->hash())
+                continue;
+
+            if (l->_name != r->_name ||
+                l->_text != r->_text ||
+                l->_attributes != r->_attributes ||
+                l->_children.size() != r->_children.size())
+            {
+                dest.emplace_back(l, r);
+                continue;
+            }
+
+            // push in reverse so pairs are reported in document order
+            for (size_t i = l->_children.size(); i > 0; --i)
+                stack.emplace_back(l->_children[i - 1], r->_children[i - 1]);
+        }
+    }
+
+    void Node::relinkChildren()
+    {
+        // The sibling links and the index both
+        // depend on the order of the children.
+        Node* prev = nullptr;
+        for (Node* child : _children)
+        {
+            if (prev)
+                prev->_next = child;
+            prev = child;
+        }
+        if (prev)
+            prev->_next = nullptr;
+        invalidateIndex();
+        invalidateHash();
+    }
+
+    void Node::siblingsOf(NodeArray& dest, const std::string_view tag) const
+    {
+        const NameRange range = siblingsOf(tag);
+        dest.insert(dest.end(), range.begin(), range.end());
     }
 
-    void Node::siblingsOf(NodeArray& dest, const String& tag) const
+    NameRange Node::siblingsOf(const std::string_view tag) const
     {
         if (tag.empty())
             throw Exception("the supplied tag can not be empty");
 
-        for (Node* child : _children)
+        if (const ChildIndex* idx = index())
         {
-            if (child->isTypeOf(tag.c_str()))
-                dest.push_back(child);
+            if (const auto it = idx->byName.find(tag);
+                it != idx->byName.end())
+                return {it->second, tag};
+            return {};
         }
+        return {_children, tag};
     }
 
     void Node::clearChildren()
     {
+        invalidateIndex();
+        invalidateHash();
+
         if (_childrenDetached)
             _children.clear();
         else
@@ -245,7 +584,7 @@ namespace Rt2::Xml
         return nullptr;
     }
 
-    Node* Node::getFirstChild(const String& requireType) const
+    Node* Node::getFirstChild(const std::string_view requireType) const
     {
         if (requireType.empty())
             return firstChild();
@@ -280,25 +619,33 @@ namespace Rt2::Xml
         return chi;
     }
 
-    Node* Node::firstChildOf(const String& tag) const
+    Node* Node::firstChildOf(const std::string_view tag) const
     {
         if (tag.empty())
             throw Exception("the supplied tag can not be empty");
 
+        if (const ChildIndex* idx = index())
+        {
+            if (const auto it = idx->byName.find(tag);
+                it != idx->byName.end())
+                return it->second.front();
+            return nullptr;
+        }
+
         for (Node* child : _children)
         {
-            if (child->isTypeOf(tag.c_str()))
+            if (child->isTypeOf(tag))
                 return child;
         }
         return nullptr;
     }
 
-    Node* Node::firstParentOf(const String& tag)
+    Node* Node::firstParentOf(const std::string_view tag)
     {
         Node* cur = this;
         while (cur)
         {
-            if (cur->isTypeOf(tag.c_str()))
+            if (cur->isTypeOf(tag))
                 break;
             cur = cur->_parent;
         }
@@ -319,6 +666,14 @@ namespace Rt2::Xml
 
     Node* Node::firstChildOf(const int64_t& tag) const
     {
+        if (const ChildIndex* idx = index())
+        {
+            if (const auto it = idx->byType.find(tag);
+                it != idx->byType.end())
+                return it->second.front();
+            return nullptr;
+        }
+
         for (Node* child : _children)
         {
             if (child->isTypeOf(tag))
@@ -327,7 +682,7 @@ namespace Rt2::Xml
         return nullptr;
     }
 
-    Node* Node::nextSiblingOf(const String& tag) const
+    Node* Node::nextSiblingOf(const std::string_view tag) const
     {
         if (tag.empty())
             throw Exception("the supplied tag can not be empty");
@@ -335,7 +690,7 @@ namespace Rt2::Xml
         Node* nd = _next;
         while (nd != nullptr)
         {
-            if (nd->isTypeOf(tag.c_str()))
+            if (nd->isTypeOf(tag))
                 return nd;
             nd = nd->_next;
         }
@@ -21,21 +21,116 @@
 */
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+#include <ranges>
+#ifdef RT_OPEN_MP
+    #include <omp.h>
+#endif
 #include "TypeFilter.h"
 #include "Utils/String.h"
+#include "Xml/MemoryUsage.h"
+#include "Xml/Sort.h"
+#include "Xml/StringHash.h"
 
 namespace Rt2::Xml
 {
     class Node;
     class Attribute;
+    struct ChildIndex;
+
+    template <typename Key>
+    class NodeRange;
+
+    /**
+     * \brief The number of children a node needs before name and type
+     * lookups build a ChildIndex instead of scanning the children.
+     */
+    constexpr size_t ChildIndexThreshold = 32;
 
     using NodeSortFunc = std::function<bool(Node* a, Node* b)>;
 
-    typedef std::unordered_map<String, String> AttributeMap;
-    typedef std::unordered_map<String, Node*>  NodeMap;
-    typedef std::vector<Node*>                 NodeArray;
+    /**
+     * \brief The value a traversal callback returns to steer the walk.
+     */
+    enum TraverseAction
+    {
+        TRAVERSE_CONTINUE = 0,
+        TRAVERSE_SKIP,  // do not visit the children of the current node
+        TRAVERSE_STOP,  // end the traversal
+    };
+
+    /**
+     * \brief The number of levels a traversal can reach before its stack
+     * moves from local storage to the heap.
+     */
+    constexpr size_t TraverseStackSize = 64;
+
+    /**
+     * \brief The number of work units parallelTraverse aims to
+     * give each thread, so that uneven subtrees balance out.
+     */
+    constexpr size_t ParallelUnitsPerThread = 8;
+
+    typedef std::unordered_map<String, String, StringHash, StringEqual> AttributeMap;
+    typedef std::unordered_map<String, Node*>                           NodeMap;
+    typedef std::vector<Node*>                                          NodeArray;
+    typedef std::vector<std::pair<const Node*, const Node*>>            NodePairArray;
+
+    /**
+     * \brief A list of child indices that leads from a root node to one of its descendants.
+     * An empty path refers to the root node itself.
+     */
+    using NodePath = std::vector<size_t>;
+
+    using TypeRange = NodeRange<int64_t>;
+    using NameRange = NodeRange<std::string_view>;
+
+    /**
+     * \brief Copies the tree at root in document order with an explicit stack.
+     *
+     * Works for any node type whose children() returns a container of
+     * pointers, raw or shared.
+     * \param root The source tree.
+     * \param copy Called as copy(src, parent) for every source node, where parent
+     * is the copy of src's parent or null for root. It creates and attaches the
+     * copy and returns it, or returns null to drop src along with its children.
+     * \return The copy of root, or null if it was dropped.
+     */
+    template <typename Dst, typename Src, typename Copy>
+    Dst* copyTree(const Src* root, Copy&& copy)
+    {
+        // Pairs of the node being copied and the
+        // already copied parent that it attaches to.
+        std::vector<std::pair<const Src*, Dst*>> stack;
+        stack.emplace_back(root, nullptr);
+
+        Dst* result = nullptr;
+        while (!stack.empty())
+        {
+            const auto [src, parent] = stack.back();
+            stack.pop_back();
+
+            Dst* dst = copy(src, parent);
+            if (!dst)
+                continue;
+            if (!parent)
+                result = dst;
+
+            // push in reverse so that the children
+            // are attached in their original order
+            const auto& children = src->children();
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
+                stack.emplace_back(&**it, dst);
+        }
+        return result;
+    }
 
     class Node
     {
@@ -49,6 +144,24 @@ namespace Rt2::Xml
         NodeArray    _children;
         bool         _childrenDetached{false};
 
+        // Built on first use by const lookups, so it is published
+        // with a compare and swap to keep concurrent readers safe.
+        mutable std::atomic<ChildIndex*> _index{nullptr};
+
+        // Zero until hash() is called, and reset to
+        // zero by any change to this node or below it.
+        mutable std::atomic<uint64_t> _hash{0};
+
+        const ChildIndex* index() const;
+
+        void invalidateIndex();
+
+        void relinkChildren();
+
+        void invalidateHash();
+
+        uint64_t computeHash() const;
+
     public:
         Node() = default;
 
@@ -60,10 +173,53 @@ namespace Rt2::Xml
 
         void addChild(Node* child);
 
+        /**
+         * \brief Inserts a child before the child at index.
+         * \param index The position of the new child. Clamped to the number of children.
+         */
+        void insertChild(size_t index, Node* child);
+
+        /**
+         * \brief Removes the child at index without deleting it.
+         * \return The child, which the caller now owns, or null if the index is out of range.
+         */
+        Node* detachChild(size_t index);
+
+        /**
+         * \brief Removes the child at index and deletes it, unless
+         * the children of this node are detached.
+         */
+        void removeChild(size_t index);
+
+        /**
+         * \brief Makes a deep copy of this node and all of its children.
+         * \return A new node that the caller is responsible for deleting.
+         */
+        Node* clone() const;
+
+        /**
+         * \brief Makes a deep copy that only keeps the nodes named in filter.
+         *
+         * The same rule as a filtered read applies; a node that is not in
+         * the filter is dropped along with its children, and every kept node
+         * takes the filter's type code. An empty filter keeps everything.
+         * \return A new node that the caller is responsible for deleting, or
+         * null if this node is not in the filter.
+         */
+        Node* clone(const TypeFilterMap& filter) const;
+
         const NodeArray& children() const;
 
         void childrenOf(int type, NodeArray& dest) const;
 
+        /**
+         * \brief Provides a lazy view of the children that have the supplied type code.
+         *
+         * Nothing is copied, matches are found as the range is iterated.
+         * The range is invalidated by any change to the children of this node.
+         */
+        TypeRange childrenOf(int64_t type) const;
+
         Node* at(const size_t& idx);
 
         const Node* at(const size_t& idx) const;
@@ -78,6 +234,8 @@ namespace Rt2::Xml
 
         void text(const String& text);
 
+        void text(String&& text);
+
         int64_t type() const;
 
         [[deprecated("use type()")]] int64_t getTypeCode() const;
@@ -86,17 +244,46 @@ namespace Rt2::Xml
 
         const AttributeMap& attributes() const;
 
-        const String& get(const String& attribute);
+        const String& get(std::string_view attribute);
+
+        bool contains(std::string_view attribute) const;
 
-        bool contains(const String& attribute) const;
+        /**
+         * \brief Adds a new attribute to this node.
+         * \return True if the attribute was added, or false if the key is
+         * already in use. An existing value is never replaced.
+         */
+        bool insert(const String& key, const String& v);
 
-        void insert(const String& key, const String& v);
+        /**
+         * \brief Adds a new attribute to this node by moving the key and value into place.
+         * \return True if the attribute was added, or false if the key is
+         * already in use. On failure, neither argument is moved from.
+         */
+        bool insert(String&& key, String&& v);
 
-        void insert(const char* key, int v);
+        bool insert(const char* key, int v);
 
-        void insert(const char* key, double v);
+        bool insert(const char* key, double v);
 
-        void siblingsOf(NodeArray&, const String& tag) const;
+        /**
+         * \brief Adds an attribute or replaces the value of an existing one.
+         */
+        void setAttribute(const String& key, const String& v);
+
+        /**
+         * \return True if the attribute existed and was removed.
+         */
+        bool removeAttribute(std::string_view key);
+
+        void siblingsOf(NodeArray&, std::string_view tag) const;
+
+        /**
+         * \brief Provides a lazy view of the children that are named tag.
+         * \throws Exception if the tag is empty.
+         * \see childrenOf(int64_t)
+         */
+        NameRange siblingsOf(std::string_view tag) const;
 
         void clearChildren();
 
@@ -104,38 +291,47 @@ namespace Rt2::Xml
 
         Node* firstChild() const;
 
-        Node* getFirstChild(const String& requireType) const;
+        Node* getFirstChild(std::string_view requireType) const;
 
         Node* getFirstChild(const int64_t& requireType) const;
 
-        Node* firstChildOf(const String& tag) const;
+        Node* firstChildOf(std::string_view tag) const;
 
         Node* firstChildOf(const int64_t& tag) const;
 
-        Node* firstParentOf(const String& tag);
+        Node* firstParentOf(std::string_view tag);
 
         Node* firstParentOf(const int64_t& tag);
 
-        Node* nextSiblingOf(const String& tag) const;
+        Node* nextSiblingOf(std::string_view tag) const;
 
         Node* nextSiblingOf(const int64_t& tag) const;
 
-        const String& attribute(const String& name, const String& def = "") const;
+        const String& attribute(std::string_view name, const String& def = "") const;
 
-        int64_t integer(const String& name, int64_t def = -1) const;
+        /**
+         * \brief Converts the named attribute to an integer.
+         *
+         * The lookup and the conversion work directly on the stored
+         * value, so neither the key nor the value are copied.
+         * \return The converted value or def if it is missing or not a number.
+         */
+        int64_t integer(std::string_view name, int64_t def = -1) const;
 
-        int64_t int64(const String& name, int64_t def = -1) const;
+        int64_t int64(std::string_view name, int64_t def = -1) const;
 
-        int32_t int32(const String& name, int32_t def = -1) const;
+        int32_t int32(std::string_view name, int32_t def = -1) const;
 
-        int16_t int16(const String& name, int16_t def = -1) const;
+        int16_t int16(std::string_view name, int16_t def = -1) const;
 
-        float float32(const String& name, float def = 0.f) const;
+        float float32(std::string_view name, float def = 0.f) const;
 
-        double float64(const String& name, double def = 0.0) const;
+        double float64(std::string_view name, double def = 0.0) const;
 
         bool isTypeOf(const char* tagName) const;
 
+        bool isTypeOf(std::string_view tagName) const;
+
         bool isTypeOf(int64_t type) const;
 
         bool hasChildren() const;
@@ -144,12 +340,79 @@ namespace Rt2::Xml
 
         bool hasChild(const char* str) const;
 
+        bool hasChild(std::string_view str) const;
+
         bool hasText() const;
 
         bool hasAttributes() const;
 
+        /**
+         * \brief Computes a structural hash of this node and all of its children.
+         *
+         * The hash covers the name, the attributes in any order, the text and
+         * the hashes of the children in order. The type code is not included.
+         * Hashes are cached on every node in the subtree, and a change to a
+         * node only clears the cache of that node and its parents, so after a
+         * change only the modified path has to be hashed again.
+         */
+        uint64_t hash() const;
+
+        /**
+         * \brief Measures the memory held by this node and all of its children.
+         * \see MemoryUsage
+         */
+        MemoryUsage memoryUsage() const;
+
+        /**
+         * \brief Compares the structural hashes of two subtrees.
+         * \return True if both have the same hash. Unequal hashes always mean
+         * the trees differ. Equal hashes mean they are the same with a
+         * probability of about 1 - 2^-64.
+         */
+        bool isSameAs(const Node* other) const;
+
+        /**
+         * \brief Finds the smallest subtrees that differ between a and b.
+         *
+         * Both trees are walked together by position, and subtrees with
+         * matching hashes are skipped without being visited. A pair is
+         * reported when the nodes differ themselves or have a different
+         * number of children.
+         */
+        static void changes(const Node* a, const Node* b, NodePairArray& dest);
+
+        /**
+         * \brief Sorts the children on the calling thread, keeping the order of equal children.
+         */
         void sort(const NodeSortFunc& fnc);
 
+        /**
+         * \brief Sorts the children with a comparator that can be inlined.
+         *
+         * The order of equal children is kept. Wide nodes are sorted on
+         * multiple threads, so the comparator must be safe to call concurrently.
+         * \param cmp A callable that accepts two const Node* and returns true if
+         * the first belongs before the second. Comparators that take Node* use
+         * the NodeSortFunc overload instead.
+         */
+        template <typename Compare>
+            requires std::is_invocable_r_v<bool, Compare&, const Node*, const Node*>
+        void sort(Compare&& cmp);
+
+        /**
+         * \brief Sorts the children by a key that is computed once per child.
+         *
+         * This is meant for keys that are expensive to get, such as
+         * attributes that have to be converted to numbers.
+         * \code{.cpp}
+         * node->sortByKey([](const Node* nd) { return nd->int32("order"); });
+         * \endcode
+         * \param key A callable that accepts a const Node* and returns a
+         * value that can be compared with operator<.
+         */
+        template <typename KeyFn>
+        void sortByKey(KeyFn&& key);
+
         template <typename T>
         static void forEach(
             const NodeArray& arr,
@@ -168,8 +431,347 @@ namespace Rt2::Xml
             T*          inst,
             void (T::*pre)(const Node*),
             void (T::*post)(const Node*));
+
+        /**
+         * \brief Visits from and all of its descendants in document order.
+         *
+         * The walk uses an explicit stack, so the depth of the tree is not
+         * limited by the native stack, and it only allocates for trees that
+         * are deeper than TraverseStackSize.
+         * \param from The node to start from.
+         * \param visit Any callable that accepts a const Node*. It may return
+         * void, a bool where false stops the walk, or a TraverseAction.
+         * \return False if the walk was stopped.
+         */
+        template <typename Visit>
+        static bool preOrder(const Node* from, Visit&& visit);
+
+        /**
+         * \brief Visits from and all of its descendants, calling pre before
+         * a node's children and post after them.
+         *
+         * post is called for every node that pre was called for, including
+         * the ones whose children were skipped, unless the walk was stopped.
+         * \param pre Follows the same rules as the callable in preOrder.
+         * \param post Any callable that accepts a const Node*. It may return
+         * void or a bool where false stops the walk.
+         * \return False if the walk was stopped.
+         */
+        template <typename Pre, typename Post>
+        static bool prePostOrder(const Node* from, Pre&& pre, Post&& post);
+
+        /**
+         * \brief Visits from and all of its descendants on multiple threads.
+         *
+         * The top of the tree is visited on the calling thread until it has
+         * been split into enough independent runs of siblings, then the runs
+         * are handed out to the threads as each one finishes its last.
+         * Every node is visited exactly once and always before its
+         * descendants, but the order of unrelated nodes is unspecified.
+         *
+         * Const access to a node is safe from any number of threads, as long
+         * as nothing modifies the tree while it is being traversed. The
+         * callable itself must be safe to call concurrently.
+         * Without OpenMP support this is the same as preOrder.
+         * \param visit Follows the same rules as the callable in preOrder.
+         * Stopping is honored by all threads but units that are in progress
+         * may still visit a few nodes before they notice.
+         * \param threads The number of threads to use, or 0 for the default.
+         * \return False if the walk was stopped.
+         */
+        template <typename Visit>
+        static bool parallelTraverse(const Node* from, Visit&& visit, int threads = 0);
     };
 
+    /**
+     * \brief Is the stack used by the traversals. The first N entries
+     * are stored in place and deeper ones spill over into a vector.
+     */
+    template <typename T, size_t N>
+    class TraverseStack
+    {
+    private:
+        T              _local[N];
+        std::vector<T> _spill;
+        size_t         _size{0};
+
+    public:
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        void push(const T& val)
+        {
+            if (_size < N)
+                _local[_size] = val;
+            else
+                _spill.push_back(val);
+            ++_size;
+        }
+
+        void pop()
+        {
+            if (--_size >= N)
+                _spill.pop_back();
+        }
+
+        T& top()
+        {
+            return _size <= N ? _local[_size - 1] : _spill.back();
+        }
+    };
+
+    /**
+     * \brief Converts the return value of a traversal callback into a TraverseAction.
+     */
+    template <typename Fn>
+    TraverseAction invokeVisit(Fn& fn, const Node* node)
+    {
+        using Result = std::invoke_result_t<Fn&, const Node*>;
+        if constexpr (std::is_void_v<Result>)
+        {
+            fn(node);
+            return TRAVERSE_CONTINUE;
+        }
+        else if constexpr (std::is_same_v<Result, TraverseAction>)
+            return fn(node);
+        else
+            return fn(node) ? TRAVERSE_CONTINUE : TRAVERSE_STOP;
+    }
+
+    /**
+     * \brief Is a forward range over a run of nodes that skips every
+     * node that is not a type of the key.
+     *
+     * The range only holds pointers into the array it was made from,
+     * so it is cheap to copy and its iterators remain valid after the
+     * range itself goes out of scope.
+     */
+    template <typename Key>
+    class NodeRange
+    {
+    public:
+        class Iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = Node*;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = Node* const*;
+            using reference         = Node* const&;
+
+        private:
+            pointer _cur{nullptr};
+            pointer _end{nullptr};
+            Key     _key{};
+
+            void seek()
+            {
+                while (_cur != _end && !(*_cur)->isTypeOf(_key))
+                    ++_cur;
+            }
+
+        public:
+            Iterator() = default;
+
+            Iterator(const pointer cur, const pointer end, const Key& key) :
+                _cur(cur),
+                _end(end),
+                _key(key)
+            {
+                seek();
+            }
+
+            reference operator*() const
+            {
+                return *_cur;
+            }
+
+            pointer operator->() const
+            {
+                return _cur;
+            }
+
+            Iterator& operator++()
+            {
+                ++_cur;
+                seek();
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                Iterator it = *this;
+                ++*this;
+                return it;
+            }
+
+            bool operator==(const Iterator& rhs) const
+            {
+                return _cur == rhs._cur;
+            }
+
+            bool operator!=(const Iterator& rhs) const
+            {
+                return _cur != rhs._cur;
+            }
+        };
+
+    private:
+        Node* const* _first{nullptr};
+        Node* const* _last{nullptr};
+        Key          _key{};
+
+    public:
+        NodeRange() = default;
+
+        NodeRange(const NodeArray& arr, const Key& key) :
+            _first(arr.data()),
+            _last(arr.data() + arr.size()),
+            _key(key)
+        {
+        }
+
+        Iterator begin() const
+        {
+            return Iterator(_first, _last, _key);
+        }
+
+        Iterator end() const
+        {
+            return Iterator(_last, _last, _key);
+        }
+
+        bool empty() const
+        {
+            return begin() == end();
+        }
+    };
+
+    template <typename Visit>
+    bool Node::parallelTraverse(const Node* from, Visit&& visit, const int threads)
+    {
+#ifdef RT_OPEN_MP
+        if (!from)
+            return true;
+
+        const TraverseAction action = invokeVisit(visit, from);
+        if (action == TRAVERSE_STOP)
+            return false;
+        if (action == TRAVERSE_SKIP || from->_children.empty())
+            return true;
+
+        const int    count  = threads > 0 ? threads : omp_get_max_threads();
+        const size_t target = (size_t)count * ParallelUnitsPerThread;
+
+        // A unit is a run of siblings. Runs are split in half, and a
+        // run of one is replaced by its node's children after the node
+        // has been visited, until there are enough of them to share.
+        using Unit = std::pair<Node* const*, Node* const*>;
+
+        std::vector<Unit> units, next;
+        units.emplace_back(from->_children.data(),
+                           from->_children.data() + from->_children.size());
+
+        bool split = true;
+        while (split && units.size() < target)
+        {
+            split = false;
+            next.clear();
+            for (const Unit& unit : units)
+            {
+                const size_t len = (size_t)(unit.second - unit.first);
+                if (len > 1)
+                {
+                    next.emplace_back(unit.first, unit.first + len / 2);
+                    next.emplace_back(unit.first + len / 2, unit.second);
+                    split = true;
+                    continue;
+                }
+
+                const Node* node = *unit.first;
+                if (node->_children.empty())
+                {
+                    next.push_back(unit);
+                    continue;
+                }
+
+                const TraverseAction result = invokeVisit(visit, node);
+                if (result == TRAVERSE_STOP)
+                    return false;
+                if (result != TRAVERSE_SKIP)
+                {
+                    next.emplace_back(node->_children.data(),
+                                      node->_children.data() + node->_children.size());
+                }
+                split = true;
+            }
+            units.swap(next);
+        }
+
+        std::atomic<bool> stopped{false};
+
+        const auto guarded = [&visit, &stopped](const Node* node)
+        {
+            if (stopped.load(std::memory_order_relaxed))
+                return TRAVERSE_STOP;
+
+            const TraverseAction result = invokeVisit(visit, node);
+            if (result == TRAVERSE_STOP)
+                stopped.store(true, std::memory_order_relaxed);
+            return result;
+        };
+
+        const int total = (int)units.size();
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(count)
+        for (int i = 0; i < total; ++i)
+        {
+            for (Node* const* it = units[i].first; it != units[i].second; ++it)
+            {
+                if (!preOrder(*it, guarded))
+                    break;
+            }
+        }
+        return !stopped.load();
+#else
+        (void)threads;
+        return preOrder(from, std::forward<Visit>(visit));
+#endif
+    }
+
+    template <typename Compare>
+        requires std::is_invocable_r_v<bool, Compare&, const Node*, const Node*>
+    void Node::sort(Compare&& cmp)
+    {
+        stableSort(_children.begin(),
+                   _children.end(),
+                   [&cmp](const Node* a, const Node* b)
+                   { return cmp(a, b); });
+        relinkChildren();
+    }
+
+    template <typename KeyFn>
+    void Node::sortByKey(KeyFn&& key)
+    {
+        using Key = std::decay_t<std::invoke_result_t<KeyFn&, const Node*>>;
+
+        std::vector<std::pair<Key, Node*>> keyed;
+        keyed.reserve(_children.size());
+        for (Node* child : _children)
+            keyed.emplace_back(key((const Node*)child), child);
+
+        stableSort(keyed.begin(),
+                   keyed.end(),
+                   [](const std::pair<Key, Node*>& a, const std::pair<Key, Node*>& b)
+                   { return a.first < b.first; });
+
+        for (size_t i = 0; i < keyed.size(); ++i)
+            _children[i] = keyed[i].second;
+        relinkChildren();
+    }
+
     template <typename T>
     void Node::forEach(
         const NodeArray& arr,
@@ -186,9 +788,9 @@ namespace Rt2::Xml
         T*          inst,
         void (T::*callback)(const Node*))
     {
-        (inst->*callback)(from);
-        for (const auto& n : from->children())
-            traverse(n, inst, callback);
+        preOrder(from,
+                 [inst, callback](const Node* node)
+                 { (inst->*callback)(node); });
     }
 
     template <typename T>
@@ -198,10 +800,105 @@ namespace Rt2::Xml
         void (T::*pre)(const Node*),
         void (T::*post)(const Node*))
     {
-        (inst->*pre)(node);
-        for (const auto& n : node->children())
-            stackTraverse(n, inst, pre, post);
-        (inst->*post)(node);
+        prePostOrder(
+            node,
+            [inst, pre](const Node* nd)
+            { (inst->*pre)(nd); },
+            [inst, post](const Node* nd)
+            { (inst->*post)(nd); });
+    }
+
+    template <typename Visit>
+    bool Node::preOrder(const Node* from, Visit&& visit)
+    {
+        if (!from)
+            return true;
+
+        const TraverseAction action = invokeVisit(visit, from);
+        if (action == TRAVERSE_STOP)
+            return false;
+        if (action == TRAVERSE_SKIP || from->_children.empty())
+            return true;
+
+        // Each entry is the next child to visit and the end of its
+        // parent's children, so a level costs two pointers.
+        using Entry = std::pair<Node* const*, Node* const*>;
+
+        TraverseStack<Entry, TraverseStackSize> stack;
+        stack.push({from->_children.data(),
+                    from->_children.data() + from->_children.size()});
+
+        while (!stack.empty())
+        {
+            Entry& top = stack.top();
+            if (top.first == top.second)
+            {
+                stack.pop();
+                continue;
+            }
+
+            const Node* node = *top.first++;
+
+            const TraverseAction result = invokeVisit(visit, node);
+            if (result == TRAVERSE_STOP)
+                return false;
+
+            if (result != TRAVERSE_SKIP && !node->_children.empty())
+                stack.push({node->_children.data(),
+                            node->_children.data() + node->_children.size()});
+        }
+        return true;
+    }
+
+    template <typename Pre, typename Post>
+    bool Node::prePostOrder(const Node* from, Pre&& pre, Post&& post)
+    {
+        if (!from)
+            return true;
+
+        struct Entry
+        {
+            const Node*  node;
+            Node* const* next;
+            Node* const* end;
+        };
+
+        TraverseStack<Entry, TraverseStackSize> stack;
+
+        const auto enter = [&stack, &pre](const Node* node)
+        {
+            const TraverseAction action = invokeVisit(pre, node);
+            if (action == TRAVERSE_STOP)
+                return false;
+
+            if (action == TRAVERSE_SKIP)
+                stack.push({node, nullptr, nullptr});
+            else
+                stack.push({node,
+                            node->_children.data(),
+                            node->_children.data() + node->_children.size()});
+            return true;
+        };
+
+        if (!enter(from))
+            return false;
+
+        while (!stack.empty())
+        {
+            Entry& top = stack.top();
+            if (top.next != top.end)
+            {
+                if (!enter(*top.next++))
+                    return false;
+                continue;
+            }
+
+            const Node* node = top.node;
+            stack.pop();
+            if (invokeVisit(post, node) == TRAVERSE_STOP)
+                return false;
+        }
+        return true;
     }
 
     inline bool Node::isTypeOf(const int64_t type) const
@@ -209,6 +906,11 @@ namespace Rt2::Xml
         return _typeCode == type;
     }
 
+    inline bool Node::isTypeOf(const std::string_view tagName) const
+    {
+        return _name == tagName;
+    }
+
     inline const NodeArray& Node::children() const
     {
         return _children;
@@ -232,6 +934,13 @@ namespace Rt2::Xml
     inline void Node::text(const String& text)
     {
         _text = text;
+        invalidateHash();
+    }
+
+    inline void Node::text(String&& text)
+    {
+        _text = std::move(text);
+        invalidateHash();
     }
 
     inline const AttributeMap& Node::attributes() const
@@ -267,6 +976,17 @@ namespace Rt2::Xml
     inline void Node::setTypeCode(const int64_t code)
     {
         _typeCode = code;
+        if (_parent)
+            _parent->invalidateIndex();
     }
 
 }  // namespace Rt2::Xml
+
+namespace std::ranges
+{
+    template <typename Key>
+    inline constexpr bool enable_view<Rt2::Xml::NodeRange<Key>> = true;
+
+    template <typename Key>
+    inline constexpr bool enable_borrowed_range<Rt2::Xml::NodeRange<Key>> = true;
+}  // namespace std::ranges
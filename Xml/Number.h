@@ -0,0 +1,56 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <charconv>
+#include <string_view>
+#include "Utils/Char.h"
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief Converts an attribute value to a number in place.
+     *
+     * Leading white space and a leading '+' are skipped, then the longest
+     * valid prefix is converted.
+     * \return The converted value or def if no number could be read.
+     */
+    template <typename T>
+    T toNumber(const std::string_view value, const T def)
+    {
+        const char* first = value.data();
+        const char* last  = first + value.size();
+
+        while (first < last && isWhiteSpace(*first))
+            ++first;
+        if (first < last && *first == '+')
+            ++first;
+        if (first >= last)
+            return def;
+
+        T out{};
+        if (const auto [ptr, ec] = std::from_chars(first, last, out);
+            ec != std::errc())
+            return def;
+        return out;
+    }
+
+}  // namespace Rt2::Xml
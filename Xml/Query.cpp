@@ -0,0 +1,440 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/Query.h"
+#include <array>
+#include "Utils/Char.h"
+#include "Utils/Exception.h"
+
+namespace Rt2::Xml
+{
+    constexpr const char* QueryTextNode = "_text_node";
+
+    // Each predicate uses two counter slots per frame.
+    // The first counts the candidates that reached it,
+    // the second caches last() + 1 once it is computed.
+    constexpr size_t SlotsPerPredicate = 2;
+
+    /**
+     * \brief Recursive descent parser for the query syntax.
+     */
+    class QueryParser
+    {
+    private:
+        const String& _expr;
+        size_t        _pos{0};
+
+        template <typename... Args>
+        [[noreturn]] void error(Args&&... args) const
+        {
+            throw Exception("query '",
+                            _expr,
+                            "' column ",
+                            _pos + 1,
+                            ": ",
+                            std::forward<Args>(args)...);
+        }
+
+        char peek(const size_t offs = 0) const
+        {
+            if (_pos + offs < _expr.size())
+                return _expr[_pos + offs];
+            return 0;
+        }
+
+        void skipWhiteSpace()
+        {
+            while (isWhiteSpace(peek()))
+                ++_pos;
+        }
+
+        static bool isNameCharacter(const int ch)
+        {
+            return isLetter(ch) || isDecimal(ch) || ch == '_' || ch == ':' || ch == '-' || ch == '.';
+        }
+
+        String scanName()
+        {
+            const size_t start = _pos;
+            while (isNameCharacter(peek()))
+                ++_pos;
+
+            if (start == _pos)
+                error("expected a name");
+            return _expr.substr(start, _pos - start);
+        }
+
+        size_t scanInteger()
+        {
+            if (!isDecimal(peek()))
+                error("expected an integer");
+
+            size_t val = 0;
+            while (isDecimal(peek()))
+                val = val * 10 + (size_t)(_expr[_pos++] - '0');
+            return val;
+        }
+
+        String scanString()
+        {
+            const char quote = peek();
+            if (!isQuote(quote))
+                error("expected a quoted string");
+
+            const size_t start = ++_pos;
+            while (peek() != quote)
+            {
+                if (peek() == 0)
+                    error("unterminated string");
+                ++_pos;
+            }
+            return _expr.substr(start, _pos++ - start);
+        }
+
+        void expect(const char ch)
+        {
+            skipWhiteSpace();
+            if (peek() != ch)
+                error("expected the '", ch, "' character");
+            ++_pos;
+        }
+
+        void parsePredicate(QueryStep& step)
+        {
+            expect('[');
+            skipWhiteSpace();
+
+            QueryPredicate pred;
+            if (peek() == '@')
+            {
+                ++_pos;
+                pred.type = QP_HAS_ATTRIBUTE;
+                pred.key  = scanName();
+
+                skipWhiteSpace();
+                if (peek() == '=')
+                {
+                    ++_pos;
+                    skipWhiteSpace();
+                    pred.type  = QP_ATTRIBUTE_EQUALS;
+                    pred.value = scanString();
+                }
+            }
+            else if (isDecimal(peek()))
+            {
+                pred.type     = QP_POSITION;
+                pred.position = scanInteger();
+                if (pred.position == 0)
+                    error("positions start at 1");
+            }
+            else if (_expr.compare(_pos, 6, "last()") == 0)
+            {
+                pred.type = QP_LAST;
+                _pos += 6;
+            }
+            else
+                error("unknown predicate");
+
+            expect(']');
+
+            if (step.predicates.size() >= MaxQueryPredicates)
+                error("too many predicates, the limit is ", MaxQueryPredicates);
+            step.predicates.push_back(pred);
+        }
+
+        void parseStep(QueryStep& step)
+        {
+            skipWhiteSpace();
+            if (peek() == '*')
+            {
+                ++_pos;
+                step.anyName = true;
+            }
+            else if (peek() == '#')
+            {
+                ++_pos;
+                const bool neg = peek() == '-';
+                if (neg)
+                    ++_pos;
+
+                step.byType   = true;
+                step.typeCode = (int64_t)scanInteger();
+                if (neg)
+                    step.typeCode = -step.typeCode;
+            }
+            else
+                step.name = scanName();
+
+            skipWhiteSpace();
+            while (peek() == '[')
+            {
+                parsePredicate(step);
+                skipWhiteSpace();
+            }
+        }
+
+    public:
+        explicit QueryParser(const String& expr) :
+            _expr(expr)
+        {
+        }
+
+        void parse(std::vector<QueryStep>& steps)
+        {
+            skipWhiteSpace();
+            if (peek() == 0)
+                error("empty expression");
+
+            bool first = true;
+            while (peek() != 0)
+            {
+                QueryStep step;
+                if (peek() == '/')
+                {
+                    ++_pos;
+                    if (peek() == '/')
+                    {
+                        ++_pos;
+                        step.axis = QA_DESCENDANT;
+                    }
+                }
+                else if (!first)
+                    error("expected the '/' character");
+
+                parseStep(step);
+                first = false;
+
+                if (steps.size() >= MaxQuerySteps)
+                    error("too many steps, the limit is ", MaxQuerySteps);
+                steps.push_back(std::move(step));
+            }
+        }
+    };
+
+    Query::Query(const String& expression)
+    {
+        compile(expression);
+    }
+
+    void Query::compile(const String& expression)
+    {
+        std::vector<QueryStep> steps;
+
+        QueryParser parser(expression);
+        parser.parse(steps);
+
+        size_t offset = 0;
+        for (QueryStep& step : steps)
+        {
+            step.counterOffset = offset;
+            offset += step.predicates.size() * SlotsPerPredicate;
+        }
+
+        _steps         = std::move(steps);
+        _counterStride = offset;
+    }
+
+    inline bool testName(const QueryStep& step, const Node* node)
+    {
+        if (step.byType)
+            return node->isTypeOf(step.typeCode);
+        if (step.anyName)
+            return node->name() != QueryTextNode;
+        return node->name() == step.name;
+    }
+
+    size_t Query::countLast(const QueryStep& step,
+                            const Node*      parent,
+                            const size_t     predicate) const
+    {
+        // Counts the candidates that would reach the predicate
+        // by running the ones before it over all the children.
+        std::array<size_t, MaxQueryPredicates> seen{};
+
+        size_t total = 0;
+        for (const Node* child : parent->children())
+        {
+            if (!testName(step, child))
+                continue;
+
+            bool ok = true;
+            for (size_t i = 0; i < predicate && ok; ++i)
+            {
+                const QueryPredicate& pred = step.predicates[i];
+                switch (pred.type)
+                {
+                case QP_HAS_ATTRIBUTE:
+                    ok = child->contains(pred.key);
+                    break;
+                case QP_ATTRIBUTE_EQUALS:
+                    ok = child->contains(pred.key) && child->attribute(pred.key) == pred.value;
+                    break;
+                case QP_POSITION:
+                    ok = ++seen[i] == pred.position;
+                    break;
+                case QP_LAST:
+                    ok = ++seen[i] == countLast(step, parent, i);
+                    break;
+                }
+            }
+            if (ok)
+                ++total;
+        }
+        return total;
+    }
+
+    bool Query::matches(const QueryStep& step,
+                        const Node*      parent,
+                        const Node*      child,
+                        size_t*          counters) const
+    {
+        if (!testName(step, child))
+            return false;
+
+        for (size_t i = 0; i < step.predicates.size(); ++i)
+        {
+            const QueryPredicate& pred = step.predicates[i];
+
+            size_t* slot = counters + i * SlotsPerPredicate;
+            switch (pred.type)
+            {
+            case QP_HAS_ATTRIBUTE:
+                if (!child->contains(pred.key))
+                    return false;
+                break;
+            case QP_ATTRIBUTE_EQUALS:
+                if (!child->contains(pred.key) || child->attribute(pred.key) != pred.value)
+                    return false;
+                break;
+            case QP_POSITION:
+                if (++slot[0] != pred.position)
+                    return false;
+                break;
+            case QP_LAST:
+                if (slot[1] == 0)
+                    slot[1] = countLast(step, parent, i) + 1;
+                if (++slot[0] != slot[1] - 1)
+                    return false;
+                break;
+            }
+        }
+        return true;
+    }
+
+    void Query::run(const Node* context, const Callback callback, void* user) const
+    {
+        if (!context || !callback || _steps.empty())
+            return;
+
+        // Each frame holds a bit set of the steps that the frame's
+        // node is a context for. A child that matches step k makes
+        // k + 1 active for its own children, and descendant steps
+        // stay active all the way down.
+        struct Frame
+        {
+            const Node* node;
+            size_t      next;
+            uint64_t    mask;
+        };
+
+        const size_t last = _steps.size() - 1;
+
+        std::vector<Frame>  stack;
+        std::vector<size_t> counters;
+        stack.reserve(16);
+        counters.reserve(16 * _counterStride);
+
+        stack.push_back({context, 0, 1});
+        counters.resize(_counterStride, 0);
+
+        while (!stack.empty())
+        {
+            Frame& frame = stack.back();
+            if (frame.next >= frame.node->size())
+            {
+                stack.pop_back();
+                counters.resize(stack.size() * _counterStride);
+                continue;
+            }
+
+            Node*    child     = frame.node->children()[frame.next++];
+            size_t*  base      = counters.data() + (stack.size() - 1) * _counterStride;
+            bool     isMatch   = false;
+            uint64_t childMask = 0;
+
+            for (size_t k = 0; k <= last; ++k)
+            {
+                if (!(frame.mask & (uint64_t(1) << k)))
+                    continue;
+
+                const QueryStep& step = _steps[k];
+                if (step.axis == QA_DESCENDANT)
+                    childMask |= uint64_t(1) << k;
+
+                if (matches(step, frame.node, child, base + step.counterOffset))
+                {
+                    if (k == last)
+                        isMatch = true;
+                    else
+                        childMask |= uint64_t(1) << (k + 1);
+                }
+            }
+
+            if (isMatch && !callback(user, child))
+                return;
+
+            if (childMask != 0 && child->hasChildren())
+            {
+                stack.push_back({child, 0, childMask});
+                counters.resize(stack.size() * _counterStride, 0);
+            }
+        }
+    }
+
+    void Query::select(const Node* context, NodeArray& dest) const
+    {
+        forEach(context,
+                [&dest](Node* node)
+                { dest.push_back(node); });
+    }
+
+    Node* Query::first(const Node* context) const
+    {
+        Node* found = nullptr;
+        forEach(context,
+                [&found](Node* node)
+                {
+                    found = node;
+                    return false;
+                });
+        return found;
+    }
+
+    size_t Query::count(const Node* context) const
+    {
+        size_t total = 0;
+        forEach(context,
+                [&total](Node*)
+                { ++total; });
+        return total;
+    }
+
+}  // namespace Rt2::Xml
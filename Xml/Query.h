@@ -0,0 +1,191 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <type_traits>
+#include <vector>
+#include "Utils/String.h"
+#include "Xml/Node.h"
+
+namespace Rt2::Xml
+{
+    constexpr size_t MaxQuerySteps      = 64;
+    constexpr size_t MaxQueryPredicates = 8;
+
+    enum QueryAxis
+    {
+        QA_CHILD,
+        QA_DESCENDANT,
+    };
+
+    enum QueryPredicateType
+    {
+        QP_HAS_ATTRIBUTE,
+        QP_ATTRIBUTE_EQUALS,
+        QP_POSITION,
+        QP_LAST,
+    };
+
+    struct QueryPredicate
+    {
+        QueryPredicateType type{QP_POSITION};
+        String             key;
+        String             value;
+        size_t             position{0};
+    };
+
+    struct QueryStep
+    {
+        QueryAxis                   axis{QA_CHILD};
+        String                      name;
+        int64_t                     typeCode{-1};
+        bool                        anyName{false};
+        bool                        byType{false};
+        std::vector<QueryPredicate> predicates;
+        size_t                      counterOffset{0};
+    };
+
+    /**
+     * \brief Is a compiled query over a Node tree that supports a subset of XPath.
+     *
+     * The expression is compiled once and can then be run any number of
+     * times, against any context node. It is evaluated in a single pre-order
+     * walk of the context's subtree that only visits the branches that can
+     * still match, so no intermediate node arrays are built. Matches are
+     * reported in document order and each node is reported once.
+     *
+     * <b>Supported syntax</b>
+     * \code{.txt}
+     * a/b          children named b of the children named a
+     * //b          any descendant named b
+     * a//b         any descendant named b of the children named a
+     * *            any element, '_text_node' children are skipped
+     * #12          any node with the type code 12
+     * b[@id]       b elements that have an id attribute
+     * b[@id='4']   b elements where id equals 4
+     * b[2]         the second b of each parent (1-based)
+     * b[last()]    the last b of each parent
+     * \endcode
+     * A leading '/' is accepted but has no effect, paths always start at the
+     * context node. Predicates apply in order, so b[@x][1] is the first b that has x.
+     *
+     * \code{.cpp}
+     * const Xml::Query query("scene//mesh[@visible='1']");
+     * query.forEach(root, [](Xml::Node* mesh) { ... });
+     * \endcode
+     */
+    class Query
+    {
+    public:
+        /**
+         * \brief Receives a match. Returning false stops the query.
+         */
+        using Callback = bool (*)(void* user, Node* node);
+
+    private:
+        std::vector<QueryStep> _steps;
+        size_t                 _counterStride{0};
+
+        bool matches(const QueryStep& step,
+                     const Node*      parent,
+                     const Node*      child,
+                     size_t*          counters) const;
+
+        size_t countLast(const QueryStep& step,
+                         const Node*      parent,
+                         size_t           predicate) const;
+
+    public:
+        Query() = default;
+
+        /**
+         * \brief Compiles the supplied expression.
+         * \throws Exception if the expression is not valid.
+         */
+        explicit Query(const String& expression);
+
+        /**
+         * \brief Replaces the current plan with the supplied expression.
+         * \throws Exception if the expression is not valid.
+         */
+        void compile(const String& expression);
+
+        /**
+         * \brief Provides read access to the compiled plan.
+         */
+        const std::vector<QueryStep>& steps() const;
+
+        /**
+         * \brief Runs the query and calls the callback for each match.
+         */
+        void run(const Node* context, Callback callback, void* user) const;
+
+        /**
+         * \brief Runs the query and calls fn for each match.
+         * \param context The node the query starts from.
+         * \param fn Any callable that accepts a Node*. If it returns
+         * a bool, returning false stops the query.
+         */
+        template <typename Fn>
+        void forEach(const Node* context, Fn&& fn) const;
+
+        /**
+         * \brief Appends every match to dest.
+         */
+        void select(const Node* context, NodeArray& dest) const;
+
+        /**
+         * \return The first match or null.
+         */
+        Node* first(const Node* context) const;
+
+        /**
+         * \return The number of matches.
+         */
+        size_t count(const Node* context) const;
+    };
+
+    inline const std::vector<QueryStep>& Query::steps() const
+    {
+        return _steps;
+    }
+
+    template <typename Fn>
+    void Query::forEach(const Node* context, Fn&& fn) const
+    {
+        using Func = std::remove_reference_t<Fn>;
+        run(
+            context,
+            [](void* user, Node* node) -> bool
+            {
+                Func& func = *static_cast<Func*>(user);
+                if constexpr (std::is_same_v<std::invoke_result_t<Func&, Node*>, void>)
+                {
+                    func(node);
+                    return true;
+                }
+                else
+                    return (bool)func(node);
+            },
+            (void*)&fn);
+    }
+
+}  // namespace Rt2::Xml
@@ -20,6 +20,7 @@
 -------------------------------------------------------------------------------
 */
 #include "Xml/Scanner.h"
+#include "Xml/MemoryUsage.h"
 #include "Xml/SpecialChar.h"
 #include "Utils/Char.h"
 #include "Xml/Token.h"
@@ -52,6 +53,22 @@ namespace Rt2::Xml
             syntaxError("code index out of bounds");
     }
 
+    void Scanner::takeCode(String& dest, const size_t& idx)
+    {
+        if (idx < _code.size())
+            dest = std::move(_code.at(idx));
+        else
+            syntaxError("code index out of bounds");
+    }
+
+    size_t Scanner::memoryUsage() const
+    {
+        size_t bytes = heapBytes(_code);
+        for (const String& code : _code)
+            bytes += heapBytes(code);
+        return bytes;
+    }
+
     void Scanner::scanString(Token& tok)
     {
         int ch = _stream->get();
@@ -188,13 +205,19 @@ namespace Rt2::Xml
                 _stream->putback((char)ch);
 
                 String dest = oss.str();
+                if (dest.find('&') != String::npos)
+                {
+                    String decoded;
+                    SpecialChar::decode(decoded, dest);
+                    dest = std::move(decoded);
+                }
 
                 _defaultState = true;
 
                 if (!dest.empty() && !onlyWhiteSpace)
                 {
                     tok.setIndex(_code.size());
-                    _code.push_back(dest);
+                    _code.push_back(std::move(dest));
                     tok.setType(TOK_TEXT);
                     return;
                 }
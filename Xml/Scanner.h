@@ -47,5 +47,17 @@ namespace Rt2::Xml
         void scan(Token& tok) override;
 
         void getCode(String& dest, const size_t& idx);
+
+        /**
+         * \brief Moves the content text at the supplied index into dest.
+         * The stored text is left empty, so it should only be used once per token.
+         */
+        void takeCode(String& dest, const size_t& idx);
+
+        /**
+         * \return The bytes held by the content text table, including
+         * the text of tokens that have not been taken.
+         */
+        size_t memoryUsage() const;
     };
 }  // namespace Rt2::Xml
@@ -0,0 +1,283 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Utils/String.h"
+#include "Xml/BufferReader.h"
+#include "Xml/Number.h"
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief Converts an attribute value or text into a bound field.
+     *
+     * Arithmetic types use toNumber and keep their current value, which
+     * is the member's default initializer, if the text is not a number. A bool is true for "true" or "1".
+     */
+    template <typename M>
+    void bindValue(const std::string_view value, M& dest)
+    {
+        if constexpr (std::is_same_v<M, bool>)
+            dest = value == "true" || value == "1";
+        else if constexpr (std::is_arithmetic_v<M>)
+            dest = toNumber<M>(value, dest);
+        else if constexpr (std::is_same_v<M, String>)
+            dest.assign(value.data(), value.size());
+        else
+            static_assert(std::is_same_v<M, String>, "unsupported field type");
+    }
+
+    /**
+     * \brief Describes how an element maps onto the struct T.
+     *
+     * Attributes are converted straight from the buffer into the struct's
+     * members and child elements are read by their own schema, so a document
+     * can be loaded into typed records in one pass without building any Node.
+     * Attributes and elements that are not described are skipped.
+     *
+     * \code{.cpp}
+     * struct Vertex { float x, y; };
+     * struct Mesh   { String name; int32_t count; std::vector<Vertex> vertices; };
+     *
+     * const auto vertex = Xml::Schema<Vertex>()
+     *                         .attribute("x", &Vertex::x)
+     *                         .attribute("y", &Vertex::y);
+     *
+     * const auto mesh = Xml::Schema<Mesh>()
+     *                       .attribute("name", &Mesh::name)
+     *                       .attribute("count", &Mesh::count)
+     *                       .children("vertex", &Mesh::vertices, vertex);
+     *
+     * std::vector<Mesh> meshes;
+     * Xml::bindAll(buffer, "mesh", mesh, meshes);
+     * \endcode
+     */
+    template <typename T>
+    class Schema
+    {
+    public:
+        using AttributeFunc = std::function<void(T&, std::string_view)>;
+        using ElementFunc   = std::function<void(T&, BufferReader&)>;
+
+    private:
+        struct AttributeField
+        {
+            std::string_view name;
+            AttributeFunc    read;
+        };
+
+        struct ElementField
+        {
+            std::string_view name;
+            ElementFunc      read;
+        };
+
+        std::vector<AttributeField> _attributes;
+        std::vector<ElementField>   _elements;
+        AttributeFunc               _text;
+
+    public:
+        /**
+         * \brief Binds the named attribute to a member.
+         * \param name The attribute name. It must outlive the schema.
+         */
+        template <typename M>
+        Schema& attribute(std::string_view name, M T::*member);
+
+        /**
+         * \brief Binds the text of the element to a member.
+         */
+        template <typename M>
+        Schema& text(M T::*member);
+
+        /**
+         * \brief Binds the text of a child element to a member,
+         * as in <mesh><name>text</name></mesh>.
+         */
+        template <typename M>
+        Schema& element(std::string_view name, M T::*member);
+
+        /**
+         * \brief Binds a child element to a nested struct.
+         * The schema is copied, so it does not need to outlive this one.
+         */
+        template <typename C>
+        Schema& child(std::string_view name, C T::*member, const Schema<C>& schema);
+
+        /**
+         * \brief Appends a record to the vector for each child element with the name.
+         */
+        template <typename C>
+        Schema& children(std::string_view name, std::vector<C> T::*member, const Schema<C>& schema);
+
+        /**
+         * \brief Reads the current element into dest.
+         *
+         * The reader must have just returned READ_START_TAG for the element.
+         * On return the element's end tag has been consumed.
+         */
+        void read(BufferReader& reader, T& dest) const;
+    };
+
+    template <typename T>
+    template <typename M>
+    Schema<T>& Schema<T>::attribute(const std::string_view name, M T::*member)
+    {
+        _attributes.push_back({name,
+                               [member](T& dest, const std::string_view value)
+                               { bindValue(value, dest.*member); }});
+        return *this;
+    }
+
+    template <typename T>
+    template <typename M>
+    Schema<T>& Schema<T>::text(M T::*member)
+    {
+        _text = [member](T& dest, const std::string_view value)
+        { bindValue(value, dest.*member); };
+        return *this;
+    }
+
+    template <typename T>
+    template <typename M>
+    Schema<T>& Schema<T>::element(const std::string_view name, M T::*member)
+    {
+        _elements.push_back({name,
+                             [member](T& dest, BufferReader& reader)
+                             {
+                                 const size_t depth = reader.depth();
+                                 while (reader.depth() >= depth)
+                                 {
+                                     const ReadEvent ev = reader.next();
+                                     if (ev == READ_EOF)
+                                         break;
+                                     if (ev == READ_TEXT)
+                                         bindValue(reader.text(), dest.*member);
+                                     else if (ev == READ_START_TAG)
+                                         reader.skipElement();
+                                 }
+                             }});
+        return *this;
+    }
+
+    template <typename T>
+    template <typename C>
+    Schema<T>& Schema<T>::child(const std::string_view name, C T::*member, const Schema<C>& schema)
+    {
+        _elements.push_back({name,
+                             [member, schema](T& dest, BufferReader& reader)
+                             { schema.read(reader, dest.*member); }});
+        return *this;
+    }
+
+    template <typename T>
+    template <typename C>
+    Schema<T>& Schema<T>::children(const std::string_view name,
+                                   std::vector<C> T::*member,
+                                   const Schema<C>&   schema)
+    {
+        _elements.push_back({name,
+                             [member, schema](T& dest, BufferReader& reader)
+                             { schema.read(reader, (dest.*member).emplace_back()); }});
+        return *this;
+    }
+
+    template <typename T>
+    void Schema<T>::read(BufferReader& reader, T& dest) const
+    {
+        for (const auto& [key, value] : reader.attributes())
+        {
+            for (const AttributeField& field : _attributes)
+            {
+                if (field.name == key)
+                {
+                    field.read(dest, value);
+                    break;
+                }
+            }
+        }
+
+        // The start tag has already been consumed, so the
+        // element ends when the depth drops below this.
+        const size_t depth = reader.depth();
+        while (reader.depth() >= depth)
+        {
+            switch (reader.next())
+            {
+            case READ_EOF:
+                return;
+            case READ_TEXT:
+                if (_text)
+                    _text(dest, reader.text());
+                break;
+            case READ_START_TAG:
+            {
+                const ElementField* found = nullptr;
+                for (const ElementField& field : _elements)
+                {
+                    if (field.name == reader.name())
+                    {
+                        found = &field;
+                        break;
+                    }
+                }
+
+                if (found)
+                    found->read(dest, reader);
+                else
+                    reader.skipElement();
+                break;
+            }
+            case READ_END_TAG:
+                break;
+            }
+        }
+    }
+
+    /**
+     * \brief Reads every element with the supplied name from the buffer
+     * into dest, in document order.
+     *
+     * Elements are found at any depth, but one that is nested inside an
+     * element that was already bound is left to that element's schema.
+     * \throws Exception if the buffer is not well formed.
+     */
+    template <typename T>
+    void bindAll(const std::string_view buffer,
+                 const std::string_view name,
+                 const Schema<T>&       schema,
+                 std::vector<T>&        dest)
+    {
+        BufferReader reader(buffer);
+
+        ReadEvent ev;
+        while ((ev = reader.next()) != READ_EOF)
+        {
+            if (ev == READ_START_TAG && reader.name() == name)
+                schema.read(reader, dest.emplace_back());
+        }
+    }
+
+}  // namespace Rt2::Xml
@@ -0,0 +1,245 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/SharedNode.h"
+#include <algorithm>
+#include <utility>
+#include "Utils/Exception.h"
+
+namespace Rt2::Xml
+{
+    SharedNode::SharedNode(String name, const int64_t typeCode) :
+        _typeCode(typeCode),
+        _name(std::move(name))
+    {
+    }
+
+    const String& SharedNode::attribute(const std::string_view name, const String& def) const
+    {
+        if (const auto it = _attributes.find(name);
+            it != _attributes.end())
+            return it->second;
+        return def;
+    }
+
+    bool SharedNode::contains(const std::string_view attribute) const
+    {
+        return _attributes.find(attribute) != _attributes.end();
+    }
+
+    const SharedNodePtr& SharedNode::at(const size_t idx) const
+    {
+        if (idx >= _children.size())
+            throw Exception("child index out of bounds");
+        return _children[idx];
+    }
+
+    Node* SharedNode::toNode() const
+    {
+        return copyTree<Node>(
+            this,
+            [](const SharedNode* src, Node* parent)
+            {
+                Node* dst = new Node(src->_name, src->_typeCode);
+                dst->text(src->_text);
+                for (const auto& [k, v] : src->_attributes)
+                    dst->insert(k, v);
+
+                if (parent)
+                    parent->addChild(dst);
+                return dst;
+            });
+    }
+
+    SharedNodePtr SharedNode::fromNode(const Node* node)
+    {
+        if (!node)
+            return nullptr;
+
+        // The nodes are only mutable while they are being
+        // built, after this returns they are only reachable
+        // through const pointers.
+        using MutablePtr = std::shared_ptr<SharedNode>;
+
+        MutablePtr root;
+        copyTree<SharedNode>(
+            node,
+            [&root](const Node* src, SharedNode* parent)
+            {
+                const MutablePtr dst = std::make_shared<SharedNode>(src->name(), src->type());
+                dst->_text       = src->text();
+                dst->_attributes = src->attributes();
+                dst->_children.reserve(src->size());
+
+                if (parent)
+                    parent->_children.push_back(dst);
+                else
+                    root = dst;
+                return dst.get();
+            });
+        return root;
+    }
+
+    const SharedNode* SharedNode::find(const SharedNodePtr& root, const NodePath& path)
+    {
+        const SharedNode* cur = root.get();
+        for (const size_t idx : path)
+        {
+            if (!cur || idx >= cur->_children.size())
+                return nullptr;
+            cur = cur->_children[idx].get();
+        }
+        return cur;
+    }
+
+    template <typename Fn>
+    SharedNodePtr SharedNode::modify(const SharedNodePtr& root,
+                                     const NodePath&      path,
+                                     Fn                   fn)
+    {
+        if (!root)
+            throw Exception("invalid root node");
+
+        std::vector<const SharedNode*> nodes;
+        nodes.reserve(path.size() + 1);
+
+        const SharedNode* cur = root.get();
+        nodes.push_back(cur);
+        for (const size_t idx : path)
+        {
+            if (idx >= cur->_children.size())
+                throw Exception("node path index out of bounds: ", idx);
+            cur = cur->_children[idx].get();
+            nodes.push_back(cur);
+        }
+
+        // Copy the last node, apply the change, then copy each
+        // parent on the way back up so that it refers to the
+        // new child. Everything off of the path is shared.
+        const auto copy = std::make_shared<SharedNode>(*nodes.back());
+        fn(*copy);
+
+        SharedNodePtr result = copy;
+        for (size_t i = path.size(); i > 0; --i)
+        {
+            const auto parent = std::make_shared<SharedNode>(*nodes[i - 1]);
+
+            parent->_children[path[i - 1]] = std::move(result);
+            result                         = parent;
+        }
+        return result;
+    }
+
+    SharedNodePtr SharedNode::setAttribute(const SharedNodePtr& root,
+                                           const NodePath&      path,
+                                           const String&        key,
+                                           const String&        value)
+    {
+        if (key.empty())
+            throw Exception("the supplied attribute key can not be empty");
+
+        return modify(root,
+                      path,
+                      [&key, &value](SharedNode& node)
+                      {
+                          node._attributes[key] = value;
+                      });
+    }
+
+    SharedNodePtr SharedNode::removeAttribute(const SharedNodePtr& root,
+                                              const NodePath&      path,
+                                              const String&        key)
+    {
+        return modify(root,
+                      path,
+                      [&key](SharedNode& node)
+                      {
+                          node._attributes.erase(key);
+                      });
+    }
+
+    SharedNodePtr SharedNode::setText(const SharedNodePtr& root,
+                                      const NodePath&      path,
+                                      const String&        text)
+    {
+        return modify(root,
+                      path,
+                      [&text](SharedNode& node)
+                      {
+                          node._text = text;
+                      });
+    }
+
+    SharedNodePtr SharedNode::insertChild(const SharedNodePtr& root,
+                                          const NodePath&      path,
+                                          const size_t         index,
+                                          const SharedNodePtr& child)
+    {
+        if (!child)
+            throw Exception("invalid node supplied to insertChild");
+
+        return modify(root,
+                      path,
+                      [index, &child](SharedNode& node)
+                      {
+                          const size_t at = std::min(index, node._children.size());
+                          node._children.insert(node._children.begin() + (ptrdiff_t)at, child);
+                      });
+    }
+
+    SharedNodePtr SharedNode::removeChild(const SharedNodePtr& root,
+                                          const NodePath&      path,
+                                          const size_t         index)
+    {
+        return modify(root,
+                      path,
+                      [index](SharedNode& node)
+                      {
+                          if (index >= node._children.size())
+                              throw Exception("child index out of bounds");
+                          node._children.erase(node._children.begin() + (ptrdiff_t)index);
+                      });
+    }
+
+    SharedNodePtr SharedNode::replace(const SharedNodePtr& root,
+                                      const NodePath&      path,
+                                      const SharedNodePtr& node)
+    {
+        if (!node)
+            throw Exception("invalid node supplied to replace");
+
+        if (path.empty())
+            return node;
+
+        const NodePath parent(path.begin(), path.end() - 1);
+        const size_t   index = path.back();
+
+        return modify(root,
+                      parent,
+                      [index, &node](SharedNode& par)
+                      {
+                          if (index >= par._children.size())
+                              throw Exception("child index out of bounds");
+                          par._children[index] = node;
+                      });
+    }
+
+}  // namespace Rt2::Xml
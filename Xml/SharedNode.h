@@ -0,0 +1,209 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <memory>
+#include <vector>
+#include "Utils/String.h"
+#include "Xml/Node.h"
+
+namespace Rt2::Xml
+{
+    class SharedNode;
+
+    using SharedNodePtr   = std::shared_ptr<const SharedNode>;
+    using SharedNodeArray = std::vector<SharedNodePtr>;
+
+    /**
+     * \brief Provides an immutable, reference counted version of Node.
+     *
+     * A SharedNode is never modified once it has been published. The update
+     * methods return a new root that copies only the nodes along the supplied
+     * path and shares every other subtree with the root that was passed in.
+     * Keeping both roots gives two versions of the document that differ only
+     * in the copied nodes.
+     *
+     * \code{.cpp}
+     * SharedNodePtr v0 = SharedNode::fromNode(file.root("root"));
+     * SharedNodePtr v1 = SharedNode::setAttribute(v0, {2, 0}, "x", "1");
+     *
+     * // v0->at(1) == v1->at(1), only the root, child 2 and
+     * // its first child were copied.
+     * \endcode
+     */
+    class SharedNode
+    {
+    private:
+        int64_t         _typeCode{-1};
+        String          _name;
+        String          _text;
+        AttributeMap    _attributes;
+        SharedNodeArray _children;
+
+        template <typename Fn>
+        static SharedNodePtr modify(const SharedNodePtr& root,
+                                    const NodePath&      path,
+                                    Fn                   fn);
+
+    public:
+        explicit SharedNode(String name, int64_t typeCode = -1);
+
+        const String& name() const;
+
+        const String& text() const;
+
+        int64_t type() const;
+
+        const AttributeMap& attributes() const;
+
+        const String& attribute(std::string_view name, const String& def = "") const;
+
+        bool contains(std::string_view attribute) const;
+
+        const SharedNodeArray& children() const;
+
+        const SharedNodePtr& at(size_t idx) const;
+
+        size_t size() const;
+
+        bool hasChildren() const;
+
+        bool hasText() const;
+
+        bool hasAttributes() const;
+
+        /**
+         * \brief Converts this node and all of its children back into a mutable Node tree.
+         * \return A new node that the caller is responsible for deleting.
+         */
+        Node* toNode() const;
+
+        /**
+         * \brief Creates a shared copy of the supplied node tree.
+         * \param node The root of the tree to copy.
+         * \return The shared root or null if the supplied node is null.
+         */
+        static SharedNodePtr fromNode(const Node* node);
+
+        /**
+         * \brief Follows the path from the supplied root.
+         * \return The node at the end of the path or null if the path is out of bounds.
+         */
+        static const SharedNode* find(const SharedNodePtr& root, const NodePath& path);
+
+        /**
+         * \brief Adds or replaces an attribute on the node at the end of the path.
+         * \return The new root.
+         */
+        static SharedNodePtr setAttribute(const SharedNodePtr& root,
+                                          const NodePath&      path,
+                                          const String&        key,
+                                          const String&        value);
+
+        /**
+         * \brief Removes an attribute from the node at the end of the path.
+         * \return The new root.
+         */
+        static SharedNodePtr removeAttribute(const SharedNodePtr& root,
+                                             const NodePath&      path,
+                                             const String&        key);
+
+        /**
+         * \brief Replaces the text of the node at the end of the path.
+         * \return The new root.
+         */
+        static SharedNodePtr setText(const SharedNodePtr& root,
+                                     const NodePath&      path,
+                                     const String&        text);
+
+        /**
+         * \brief Inserts a child into the node at the end of the path.
+         * \param index The position of the new child. Clamped to the number of children.
+         * \return The new root.
+         */
+        static SharedNodePtr insertChild(const SharedNodePtr& root,
+                                         const NodePath&      path,
+                                         size_t               index,
+                                         const SharedNodePtr& child);
+
+        /**
+         * \brief Removes a child from the node at the end of the path.
+         * \return The new root.
+         */
+        static SharedNodePtr removeChild(const SharedNodePtr& root,
+                                         const NodePath&      path,
+                                         size_t               index);
+
+        /**
+         * \brief Swaps the node at the end of the path with a different node.
+         * \return The new root.
+         */
+        static SharedNodePtr replace(const SharedNodePtr& root,
+                                     const NodePath&      path,
+                                     const SharedNodePtr& node);
+    };
+
+    inline const String& SharedNode::name() const
+    {
+        return _name;
+    }
+
+    inline const String& SharedNode::text() const
+    {
+        return _text;
+    }
+
+    inline int64_t SharedNode::type() const
+    {
+        return _typeCode;
+    }
+
+    inline const AttributeMap& SharedNode::attributes() const
+    {
+        return _attributes;
+    }
+
+    inline const SharedNodeArray& SharedNode::children() const
+    {
+        return _children;
+    }
+
+    inline size_t SharedNode::size() const
+    {
+        return _children.size();
+    }
+
+    inline bool SharedNode::hasChildren() const
+    {
+        return !_children.empty();
+    }
+
+    inline bool SharedNode::hasText() const
+    {
+        return !_text.empty();
+    }
+
+    inline bool SharedNode::hasAttributes() const
+    {
+        return !_attributes.empty();
+    }
+
+}  // namespace Rt2::Xml
@@ -0,0 +1,276 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/Snapshot.h"
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "Utils/Exception.h"
+#include "Xml/Node.h"
+#include "Xml/Number.h"
+
+namespace Rt2::Xml
+{
+    constexpr uint64_t MaxSnapshotIndex = std::numeric_limits<uint32_t>::max();
+
+    static bool inRange(const uint64_t offset, const uint64_t size, const uint64_t total)
+    {
+        return offset <= total && size <= total - offset;
+    }
+
+    SnapshotNode SnapshotNode::parent() const
+    {
+        const SnapshotRecord* parent = _snapshot->_nodes + _record->parent;
+        if (parent == _record)
+            return {};
+        return {_snapshot, parent};
+    }
+
+    bool SnapshotNode::contains(const std::string_view attribute) const
+    {
+        for (const auto& [k, v] : attributes())
+        {
+            if (k == attribute)
+                return true;
+        }
+        return false;
+    }
+
+    std::string_view SnapshotNode::attribute(const std::string_view name,
+                                             const std::string_view def) const
+    {
+        for (const auto& [k, v] : attributes())
+        {
+            if (k == name)
+                return v;
+        }
+        return def;
+    }
+
+    int64_t SnapshotNode::int64(const std::string_view name, const int64_t def) const
+    {
+        return toNumber<int64_t>(attribute(name), def);
+    }
+
+    int32_t SnapshotNode::int32(const std::string_view name, const int32_t def) const
+    {
+        return (int32_t)toNumber<int64_t>(attribute(name), (int64_t)def);
+    }
+
+    float SnapshotNode::float32(const std::string_view name, const float def) const
+    {
+        return toNumber<float>(attribute(name), def);
+    }
+
+    double SnapshotNode::float64(const std::string_view name, const double def) const
+    {
+        return toNumber<double>(attribute(name), def);
+    }
+
+    SnapshotNode SnapshotNode::firstChildOf(const std::string_view tag) const
+    {
+        for (const SnapshotNode child : children())
+        {
+            if (child.isTypeOf(tag))
+                return child;
+        }
+        return {};
+    }
+
+    SnapshotNode SnapshotNode::firstChildOf(const int64_t& tag) const
+    {
+        for (const SnapshotNode child : children())
+        {
+            if (child.isTypeOf(tag))
+                return child;
+        }
+        return {};
+    }
+
+    Snapshot::Snapshot(const std::string_view data)
+    {
+        attach(data);
+    }
+
+    void Snapshot::attach(const std::string_view data)
+    {
+        *this = Snapshot();
+
+        if (data.size() < sizeof(SnapshotHeader))
+            throw Exception("the snapshot is smaller than its header");
+        if ((uintptr_t)data.data() % alignof(uint64_t) != 0)
+            throw Exception("snapshot memory must be aligned to 8 bytes");
+
+        const auto* header = (const SnapshotHeader*)data.data();
+        if (std::string_view(header->magic, sizeof header->magic) != SnapshotMagic)
+            throw Exception("missing snapshot header");
+        if (header->byteOrder != SnapshotByteOrder)
+            throw Exception("the snapshot was written with a different byte order");
+
+        const uint64_t nodeBytes      = (uint64_t)header->nodeCount * sizeof(SnapshotRecord);
+        const uint64_t attributeBytes = (uint64_t)header->attributeCount * sizeof(SnapshotAttributeRecord);
+
+        if (header->nodes % alignof(SnapshotRecord) != 0 ||
+            header->attributes % alignof(SnapshotAttributeRecord) != 0 ||
+            !inRange(header->nodes, nodeBytes, data.size()) ||
+            !inRange(header->attributes, attributeBytes, data.size()) ||
+            !inRange(header->strings, header->stringSize, data.size()))
+            throw Exception("a snapshot section is out of bounds");
+
+        _data           = data;
+        _nodes          = (const SnapshotRecord*)(data.data() + header->nodes);
+        _attributes     = (const SnapshotAttributeRecord*)(data.data() + header->attributes);
+        _strings        = data.data() + header->strings;
+        _nodeCount      = header->nodeCount;
+        _attributeCount = header->attributeCount;
+        _stringSize     = header->stringSize;
+    }
+
+    void Snapshot::verify() const
+    {
+        const auto validString = [this](const SnapshotString& str)
+        {
+            return inRange(str.offset, str.size, _stringSize);
+        };
+
+        for (uint32_t i = 0; i < _attributeCount; ++i)
+        {
+            if (!validString(_attributes[i].key) || !validString(_attributes[i].value))
+                throw Exception("snapshot attribute ", i, " refers to an invalid string");
+        }
+
+        for (uint32_t i = 0; i < _nodeCount; ++i)
+        {
+            const SnapshotRecord& rec = _nodes[i];
+            if (!validString(rec.name) || !validString(rec.text))
+                throw Exception("snapshot node ", i, " refers to an invalid string");
+
+            // records are stored level by level, so parents always come
+            // first and children after, which also rules out cycles
+            if (i == 0 ? rec.parent != 0 : rec.parent >= i)
+                throw Exception("snapshot node ", i, " has an invalid parent");
+
+            if (rec.childCount > 0 &&
+                (rec.firstChild <= i || !inRange(rec.firstChild, rec.childCount, _nodeCount)))
+                throw Exception("snapshot node ", i, " has an invalid child range");
+
+            if (!inRange(rec.firstAttribute, rec.attributeCount, _attributeCount))
+                throw Exception("snapshot node ", i, " has an invalid attribute range");
+        }
+    }
+
+    SnapshotNode Snapshot::root() const
+    {
+        if (_nodeCount == 0)
+            return {};
+        return {this, _nodes};
+    }
+
+    void Snapshot::toString(String& dest, const Node* root)
+    {
+        dest.clear();
+        if (!root)
+            throw Exception("invalid node supplied to Snapshot::toString");
+
+        std::vector<const Node*>             order{root};
+        std::vector<uint32_t>                parents{0};
+        std::vector<SnapshotRecord>          records;
+        std::vector<SnapshotAttributeRecord> attributes;
+        String                               strings;
+
+        std::unordered_map<std::string_view, SnapshotString> interned;
+
+        const auto append = [&strings](const std::string_view str)
+        {
+            const SnapshotString ref{strings.size(), str.size()};
+            strings.append(str.data(), str.size());
+            return ref;
+        };
+
+        // names and keys repeat, so they are stored once
+        const auto intern = [&interned, &append](const std::string_view str)
+        {
+            const auto [it, inserted] = interned.emplace(str, SnapshotString{});
+            if (inserted)
+                it->second = append(str);
+            return it->second;
+        };
+
+        // Level order, so that the children of each node
+        // are next to each other and after their parent.
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const Node* node = order[i];
+
+            SnapshotRecord& rec = records.emplace_back();
+            rec.type            = node->type();
+            rec.name            = intern(node->name());
+            rec.text            = append(node->text());
+            rec.parent          = parents[i];
+            rec.firstChild      = (uint32_t)order.size();
+            rec.childCount      = (uint32_t)node->size();
+            rec.firstAttribute  = (uint32_t)attributes.size();
+            rec.attributeCount  = (uint32_t)node->attributes().size();
+            rec.reserved        = 0;
+
+            for (const auto& [key, value] : node->attributes())
+                attributes.push_back({intern(key), append(value)});
+
+            for (const Node* child : node->children())
+            {
+                order.push_back(child);
+                parents.push_back((uint32_t)i);
+            }
+
+            if (order.size() > MaxSnapshotIndex || attributes.size() > MaxSnapshotIndex)
+                throw Exception("too many nodes or attributes for a snapshot");
+        }
+
+        SnapshotHeader header{};
+        memcpy(header.magic, SnapshotMagic.data(), sizeof header.magic);
+        header.byteOrder      = SnapshotByteOrder;
+        header.nodeCount      = (uint32_t)records.size();
+        header.attributeCount = (uint32_t)attributes.size();
+        header.nodes          = sizeof(SnapshotHeader);
+        header.attributes     = header.nodes + records.size() * sizeof(SnapshotRecord);
+        header.strings        = header.attributes + attributes.size() * sizeof(SnapshotAttributeRecord);
+        header.stringSize     = strings.size();
+
+        dest.resize((size_t)(header.strings + header.stringSize));
+
+        char* out = dest.data();
+        memcpy(out, &header, sizeof header);
+        memcpy(out + header.nodes, records.data(), records.size() * sizeof(SnapshotRecord));
+        if (!attributes.empty())
+            memcpy(out + header.attributes, attributes.data(), attributes.size() * sizeof(SnapshotAttributeRecord));
+        if (!strings.empty())
+            memcpy(out + header.strings, strings.data(), strings.size());
+    }
+
+    void Snapshot::write(OStream& output, const Node* root)
+    {
+        String data;
+        toString(data, root);
+        output.write(data.data(), (std::streamsize)data.size());
+    }
+
+}  // namespace Rt2::Xml
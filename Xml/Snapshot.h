@@ -0,0 +1,442 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include "Utils/String.h"
+
+namespace Rt2::Xml
+{
+    class Node;
+    class Snapshot;
+
+    /**
+     * \brief The first four bytes of every snapshot.
+     */
+    constexpr std::string_view SnapshotMagic = "XMS1";
+
+    /**
+     * \brief Written into every header so that a snapshot from a
+     * machine with a different byte order is rejected.
+     */
+    constexpr uint32_t SnapshotByteOrder = 0x01020304;
+
+    /**
+     * \brief A range of the string section, relative to its start.
+     */
+    struct SnapshotString
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct SnapshotHeader
+    {
+        char     magic[4];
+        uint32_t byteOrder;
+        uint32_t nodeCount;
+        uint32_t attributeCount;
+        uint64_t nodes;       // the byte offset of the node records
+        uint64_t attributes;  // the byte offset of the attribute records
+        uint64_t strings;     // the byte offset of the string section
+        uint64_t stringSize;  // the size of the string section
+    };
+
+    /**
+     * \brief The stored form of a node. Nodes are stored level by level,
+     * so the children of a node are a contiguous range of records.
+     */
+    struct SnapshotRecord
+    {
+        int64_t        type;
+        SnapshotString name;
+        SnapshotString text;
+        uint32_t       parent;  // the root refers to itself
+        uint32_t       firstChild;
+        uint32_t       childCount;
+        uint32_t       firstAttribute;
+        uint32_t       attributeCount;
+        uint32_t       reserved;
+    };
+
+    struct SnapshotAttributeRecord
+    {
+        SnapshotString key;
+        SnapshotString value;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == 48);
+    static_assert(sizeof(SnapshotRecord) == 64);
+    static_assert(sizeof(SnapshotAttributeRecord) == 32);
+
+    /**
+     * \brief A key-value pair that refers to the memory of a Snapshot.
+     */
+    struct SnapshotAttribute
+    {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    /**
+     * \brief Is a handle to a node in a Snapshot.
+     *
+     * It is two words and is passed by value. Everything it returns
+     * is a view into the snapshot's memory, so it is only valid for as
+     * long as that memory is. A default constructed handle is invalid
+     * and every lookup that finds nothing returns one.
+     */
+    class SnapshotNode
+    {
+    private:
+        const Snapshot*       _snapshot{nullptr};
+        const SnapshotRecord* _record{nullptr};
+
+        std::string_view view(const SnapshotString& str) const;
+
+        static SnapshotAttribute attributeOf(const Snapshot*                snapshot,
+                                             const SnapshotAttributeRecord* record);
+
+    public:
+        /**
+         * \brief Forward iterator over a contiguous range of records.
+         */
+        template <typename Record, typename Value>
+        class Iterator
+        {
+        private:
+            const Snapshot* _snapshot{nullptr};
+            const Record*   _record{nullptr};
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = Value;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const Value*;
+            using reference         = Value;
+
+            Iterator() = default;
+
+            Iterator(const Snapshot* snapshot, const Record* record) :
+                _snapshot(snapshot),
+                _record(record)
+            {
+            }
+
+            Value operator*() const;
+
+            Iterator& operator++()
+            {
+                ++_record;
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                const Iterator cp = *this;
+                ++_record;
+                return cp;
+            }
+
+            bool operator==(const Iterator& rhs) const
+            {
+                return _record == rhs._record;
+            }
+
+            bool operator!=(const Iterator& rhs) const
+            {
+                return _record != rhs._record;
+            }
+        };
+
+        template <typename Record, typename Value>
+        class Range
+        {
+        private:
+            Iterator<Record, Value> _begin;
+            Iterator<Record, Value> _end;
+
+        public:
+            Range(const Snapshot* snapshot, const Record* first, const size_t count) :
+                _begin(snapshot, first),
+                _end(snapshot, first + count)
+            {
+            }
+
+            Iterator<Record, Value> begin() const
+            {
+                return _begin;
+            }
+
+            Iterator<Record, Value> end() const
+            {
+                return _end;
+            }
+        };
+
+        using ChildRange     = Range<SnapshotRecord, SnapshotNode>;
+        using AttributeRange = Range<SnapshotAttributeRecord, SnapshotAttribute>;
+
+        SnapshotNode() = default;
+
+        SnapshotNode(const Snapshot* snapshot, const SnapshotRecord* record) :
+            _snapshot(snapshot),
+            _record(record)
+        {
+        }
+
+        bool valid() const;
+
+        explicit operator bool() const;
+
+        std::string_view name() const;
+
+        std::string_view text() const;
+
+        int64_t type() const;
+
+        /**
+         * \return The parent, or an invalid handle for the root.
+         */
+        SnapshotNode parent() const;
+
+        size_t size() const;
+
+        /**
+         * \return The child at idx, or an invalid handle if it is out of range.
+         */
+        SnapshotNode at(size_t idx) const;
+
+        ChildRange children() const;
+
+        AttributeRange attributes() const;
+
+        bool contains(std::string_view attribute) const;
+
+        std::string_view attribute(std::string_view name, std::string_view def = {}) const;
+
+        int64_t int64(std::string_view name, int64_t def = -1) const;
+
+        int32_t int32(std::string_view name, int32_t def = -1) const;
+
+        float float32(std::string_view name, float def = 0.f) const;
+
+        double float64(std::string_view name, double def = 0.0) const;
+
+        SnapshotNode firstChildOf(std::string_view tag) const;
+
+        SnapshotNode firstChildOf(const int64_t& tag) const;
+
+        bool isTypeOf(std::string_view tagName) const;
+
+        bool isTypeOf(int64_t type) const;
+
+        bool hasChildren() const;
+
+        bool hasText() const;
+
+        bool hasAttributes() const;
+    };
+
+    /**
+     * \brief Provides a read-only document that is queried in place.
+     *
+     * A snapshot is a single block of memory with no pointers in it; nodes,
+     * attributes and strings refer to each other by index and offset. It
+     * can be written to a file once and then memory mapped by any number
+     * of processes, which share the same pages and start without reading
+     * or building anything.
+     *
+     * attach only checks the header and the section bounds, so it costs the
+     * same for any size of document. For memory that does not come from a
+     * trusted writer, verify checks every record before it is used.
+     *
+     * \code{.cpp}
+     * Xml::Snapshot::write(out, file.tree());
+     *
+     * // later, with the file mapped at data
+     * Xml::Snapshot snap(std::string_view(data, size));
+     * Xml::SnapshotNode root = snap.root().firstChildOf("root");
+     * \endcode
+     */
+    class Snapshot
+    {
+    private:
+        friend class SnapshotNode;
+
+        std::string_view               _data;
+        const SnapshotRecord*          _nodes{nullptr};
+        const SnapshotAttributeRecord* _attributes{nullptr};
+        const char*                    _strings{nullptr};
+        uint32_t                       _nodeCount{0};
+        uint32_t                       _attributeCount{0};
+        uint64_t                       _stringSize{0};
+
+    public:
+        Snapshot() = default;
+
+        /**
+         * \see attach
+         */
+        explicit Snapshot(std::string_view data);
+
+        /**
+         * \brief Uses data as the snapshot. Nothing is copied, so it must
+         * stay valid and unchanged for as long as this object is used.
+         * \throws Exception if the header is invalid, a section is out of
+         * bounds or data is not aligned to 8 bytes.
+         */
+        void attach(std::string_view data);
+
+        /**
+         * \brief Checks that every string, child range and attribute range
+         * is inside the snapshot.
+         * \throws Exception on the first record that is not.
+         */
+        void verify() const;
+
+        /**
+         * \return The node the snapshot was written from, or an invalid handle if empty.
+         */
+        SnapshotNode root() const;
+
+        /**
+         * \return The total number of nodes.
+         */
+        size_t size() const;
+
+        /**
+         * \brief Writes root and all of its children as a snapshot.
+         * \throws Exception if there are more than 2^32 - 1 nodes or attributes.
+         */
+        static void write(OStream& output, const Node* root);
+
+        /**
+         * \brief Replaces the contents of dest with a snapshot of root.
+         * \see write
+         */
+        static void toString(String& dest, const Node* root);
+    };
+
+    inline std::string_view SnapshotNode::view(const SnapshotString& str) const
+    {
+        return {_snapshot->_strings + str.offset, (size_t)str.size};
+    }
+
+    inline SnapshotAttribute SnapshotNode::attributeOf(const Snapshot*                snapshot,
+                                                       const SnapshotAttributeRecord* record)
+    {
+        return {{snapshot->_strings + record->key.offset, (size_t)record->key.size},
+                {snapshot->_strings + record->value.offset, (size_t)record->value.size}};
+    }
+
+    template <>
+    inline SnapshotNode SnapshotNode::Iterator<SnapshotRecord, SnapshotNode>::operator*() const
+    {
+        return {_snapshot, _record};
+    }
+
+    template <>
+    inline SnapshotAttribute SnapshotNode::Iterator<SnapshotAttributeRecord, SnapshotAttribute>::operator*() const
+    {
+        return attributeOf(_snapshot, _record);
+    }
+
+    inline bool SnapshotNode::valid() const
+    {
+        return _record != nullptr;
+    }
+
+    inline SnapshotNode::operator bool() const
+    {
+        return _record != nullptr;
+    }
+
+    inline std::string_view SnapshotNode::name() const
+    {
+        return view(_record->name);
+    }
+
+    inline std::string_view SnapshotNode::text() const
+    {
+        return view(_record->text);
+    }
+
+    inline int64_t SnapshotNode::type() const
+    {
+        return _record->type;
+    }
+
+    inline size_t SnapshotNode::size() const
+    {
+        return _record->childCount;
+    }
+
+    inline SnapshotNode SnapshotNode::at(const size_t idx) const
+    {
+        if (idx >= _record->childCount)
+            return {};
+        return {_snapshot, _snapshot->_nodes + _record->firstChild + idx};
+    }
+
+    inline SnapshotNode::ChildRange SnapshotNode::children() const
+    {
+        return {_snapshot, _snapshot->_nodes + _record->firstChild, _record->childCount};
+    }
+
+    inline SnapshotNode::AttributeRange SnapshotNode::attributes() const
+    {
+        return {_snapshot, _snapshot->_attributes + _record->firstAttribute, _record->attributeCount};
+    }
+
+    inline bool SnapshotNode::isTypeOf(const std::string_view tagName) const
+    {
+        return name() == tagName;
+    }
+
+    inline bool SnapshotNode::isTypeOf(const int64_t type) const
+    {
+        return _record->type == type;
+    }
+
+    inline bool SnapshotNode::hasChildren() const
+    {
+        return _record->childCount > 0;
+    }
+
+    inline bool SnapshotNode::hasText() const
+    {
+        return _record->text.size > 0;
+    }
+
+    inline bool SnapshotNode::hasAttributes() const
+    {
+        return _record->attributeCount > 0;
+    }
+
+    inline size_t Snapshot::size() const
+    {
+        return _nodeCount;
+    }
+
+}  // namespace Rt2::Xml
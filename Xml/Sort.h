@@ -0,0 +1,79 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#ifdef RT_OPEN_MP
+    #include <omp.h>
+#endif
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief The number of elements a range needs before
+     * stableSort splits the work across threads.
+     */
+    constexpr size_t ParallelSortThreshold = 16384;
+
+    /**
+     * \brief Sorts the range while keeping the order of equal elements.
+     *
+     * Large ranges are cut into one run per thread, the runs are sorted
+     * in parallel and then merged pairwise, also in parallel. The comparator
+     * is called from several threads at once in that case, so it must not
+     * modify shared state. Without OpenMP this is std::stable_sort.
+     */
+    template <typename It, typename Compare>
+    void stableSort(It first, It last, Compare cmp)
+    {
+#ifdef RT_OPEN_MP
+        const size_t size    = (size_t)(last - first);
+        const int    threads = omp_get_max_threads();
+        if (size >= ParallelSortThreshold && threads > 1)
+        {
+            std::vector<It> bounds((size_t)threads + 1);
+            for (int i = 0; i <= threads; ++i)
+                bounds[i] = first + (ptrdiff_t)(size * (size_t)i / (size_t)threads);
+
+    #pragma omp parallel for schedule(static)
+            for (int i = 0; i < threads; ++i)
+                std::stable_sort(bounds[i], bounds[i + 1], cmp);
+
+            for (int width = 1; width < threads; width *= 2)
+            {
+    #pragma omp parallel for schedule(static)
+                for (int i = 0; i < threads; i += 2 * width)
+                {
+                    const int mid = std::min(i + width, threads);
+                    const int end = std::min(i + 2 * width, threads);
+                    if (mid < end)
+                        std::inplace_merge(bounds[i], bounds[mid], bounds[end], cmp);
+                }
+            }
+            return;
+        }
+#endif
+        std::stable_sort(first, last, cmp);
+    }
+
+}  // namespace Rt2::Xml
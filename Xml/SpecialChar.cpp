@@ -20,6 +20,15 @@
 -------------------------------------------------------------------------------
 */
 #include "Xml/SpecialChar.h"
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define RT_SSE2 1
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
 
 namespace Rt2::Xml
 {
@@ -112,4 +121,146 @@ namespace Rt2::Xml
         return (char)in;
     }
 
+    struct EntityTable
+    {
+        std::string_view code;
+        char             ch;
+    };
+
+    constexpr EntityTable Entities[] = {
+        {  "lt;", '<'},
+        {  "gt;", '>'},
+        { "amp;", '&'},
+        {"quot;", '"'},
+        {"apos;", '\''},
+    };
+
+    void SpecialChar::decode(String& dest, std::string_view src)
+    {
+        dest.reserve(dest.size() + src.size());
+
+        size_t amp;
+        while ((amp = src.find('&')) != std::string_view::npos)
+        {
+            dest.append(src.data(), amp);
+            src.remove_prefix(amp + 1);
+
+            char ch = '&';
+            for (const auto& [code, rep] : Entities)
+            {
+                if (src.substr(0, code.size()) == code)
+                {
+                    ch = rep;
+                    src.remove_prefix(code.size());
+                    break;
+                }
+            }
+            dest.push_back(ch);
+        }
+        dest.append(src.data(), src.size());
+    }
+
+    inline bool needsEscape(const char ch)
+    {
+        return ch == '<' || ch == '>' || ch == '&' || ch == '"' || ch == '\'';
+    }
+
+    inline size_t lowestBit(const uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward(&idx, mask);
+        return (size_t)idx;
+#else
+        return (size_t)__builtin_ctz(mask);
+#endif
+    }
+
+    size_t SpecialChar::findEscape(const std::string_view src)
+    {
+        const char*  data = src.data();
+        const size_t size = src.size();
+
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i lt  = _mm256_set1_epi8('<');
+        const __m256i gt  = _mm256_set1_epi8('>');
+        const __m256i amp = _mm256_set1_epi8('&');
+        const __m256i quo = _mm256_set1_epi8('"');
+        const __m256i apo = _mm256_set1_epi8('\'');
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+
+            const __m256i hit = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, lt), _mm256_cmpeq_epi8(v, gt)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, amp), _mm256_cmpeq_epi8(v, quo))),
+                _mm256_cmpeq_epi8(v, apo));
+
+            if (const uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit))
+                return i + lowestBit(mask);
+        }
+#elif defined(RT_SSE2)
+        const __m128i lt  = _mm_set1_epi8('<');
+        const __m128i gt  = _mm_set1_epi8('>');
+        const __m128i amp = _mm_set1_epi8('&');
+        const __m128i quo = _mm_set1_epi8('"');
+        const __m128i apo = _mm_set1_epi8('\'');
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+
+            const __m128i hit = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, quo))),
+                _mm_cmpeq_epi8(v, apo));
+
+            if (const uint32_t mask = (uint32_t)_mm_movemask_epi8(hit))
+                return i + lowestBit(mask);
+        }
+#endif
+        // the tail, or everything without SIMD support
+        for (; i < size; ++i)
+        {
+            if (needsEscape(data[i]))
+                return i;
+        }
+        return size;
+    }
+
+    std::string_view SpecialChar::entity(const char ch)
+    {
+        switch (ch)
+        {
+        case '<':
+            return "&lt;";
+        case '>':
+            return "&gt;";
+        case '&':
+            return "&amp;";
+        case '"':
+            return "&quot;";
+        case '\'':
+            return "&apos;";
+        default:
+            return {};
+        }
+    }
+
+    void SpecialChar::encode(String& dest, std::string_view src)
+    {
+        size_t idx;
+        while ((idx = findEscape(src)) < src.size())
+        {
+            dest.append(src.data(), idx);
+
+            const std::string_view rep = entity(src[idx]);
+            dest.append(rep.data(), rep.size());
+            src.remove_prefix(idx + 1);
+        }
+        dest.append(src.data(), src.size());
+    }
+
 }  // namespace Rt2::Xml
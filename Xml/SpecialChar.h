@@ -20,6 +20,7 @@
 -------------------------------------------------------------------------------
 */
 #pragma once
+#include <string_view>
 #include "Utils/String.h"
 
 namespace Rt2::Xml
@@ -29,6 +30,35 @@ namespace Rt2::Xml
     {
     public:
         static char check(int in, IStream* stream);
+
+        /**
+         * \brief Appends src to dest, replacing any of the predefined
+         * entity references with the character that it represents.
+         *
+         * Sequences that are not one of the predefined references are copied as-is.
+         */
+        static void decode(String& dest, std::string_view src);
+
+        /**
+         * \brief Finds the first character in src that has to be written as
+         * an entity reference. These are '<', '>', '&', '"' and the apostrophe.
+         *
+         * Uses SSE2 or AVX2 when they are available to test 16 or 32 bytes
+         * at a time, so clean text costs little more than a copy.
+         * \return The index of the character or src.size() if there is none.
+         */
+        static size_t findEscape(std::string_view src);
+
+        /**
+         * \return The entity reference for a character that findEscape stopped at.
+         */
+        static std::string_view entity(char ch);
+
+        /**
+         * \brief Appends src to dest with every character
+         * that findEscape reports replaced by its entity.
+         */
+        static void encode(String& dest, std::string_view src);
     };
 
     using Sc = SpecialChar;
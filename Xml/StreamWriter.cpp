@@ -0,0 +1,193 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/StreamWriter.h"
+#include "Utils/Char.h"
+#include "Utils/Exception.h"
+#include "Xml/SpecialChar.h"
+
+namespace Rt2::Xml
+{
+    StreamWriter::StreamWriter(OStream& output, const int format) :
+        _stream(&output)
+    {
+        _buffer.resize(WriteBufferSize);
+
+        // the same mapping as File::write
+        _notMinify = (format & Minify) == 0;
+        if (format & Indent2)
+            _indentBy = 2;
+        else if (format & Indent4)
+            _indentBy = 4;
+        else
+            _indentBy = 1;
+    }
+
+    StreamWriter::~StreamWriter()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+            // a destructor must not throw
+        }
+    }
+
+    void StreamWriter::flush()
+    {
+        if (_used > 0)
+            _stream->write(_buffer.data(), (std::streamsize)_used);
+        _used = 0;
+    }
+
+    void StreamWriter::putEscaped(std::string_view str)
+    {
+        size_t idx;
+        while ((idx = SpecialChar::findEscape(str)) < str.size())
+        {
+            put(str.substr(0, idx));
+            put(SpecialChar::entity(str[idx]));
+            str.remove_prefix(idx + 1);
+        }
+        put(str);
+    }
+
+    void StreamWriter::pad()
+    {
+        // the root is not indented, the same as Writer
+        const size_t width = (_open.size() - 1) * (size_t)_indentBy;
+        for (size_t i = 0; i < width; ++i)
+            put(' ');
+    }
+
+    void StreamWriter::closePending()
+    {
+        if (!_pending)
+            return;
+
+        _pending = false;
+        put('>');
+    }
+
+    void StreamWriter::startElement(const std::string_view name)
+    {
+        if (_finished)
+            throw Exception("the document has already ended");
+        if (name.empty())
+            throw Exception("invalid element name");
+
+        if (_open.empty())
+        {
+            if (_hasRoot)
+                throw Exception("only one root element is allowed, found '", name, "'");
+            _hasRoot = true;
+        }
+        else if (_pending)
+        {
+            // the parent now has children and no text yet
+            closePending();
+            if (_notMinify)
+                put('\n');
+        }
+
+        _open.push_back({String(name), false});
+
+        if (_notMinify)
+            pad();
+
+        put('<');
+        put(name);
+        _pending = true;
+    }
+
+    void StreamWriter::attribute(const std::string_view name, const std::string_view value)
+    {
+        if (!_pending)
+            throw Exception("attribute '", name, "' must directly follow startElement");
+        if (name.empty())
+            throw Exception("invalid attribute name");
+
+        put(' ');
+        put(name);
+        put('=');
+        put('"');
+        putEscaped(value);
+        put('"');
+    }
+
+    void StreamWriter::attribute(const std::string_view name, const double value)
+    {
+        attribute(name, Char::toString(value));
+    }
+
+    void StreamWriter::text(const std::string_view value)
+    {
+        if (_open.empty())
+            throw Exception("text found outside of an element");
+        if (value.empty())
+            return;
+
+        closePending();
+        _open.back().hasText = true;
+        putEscaped(value);
+    }
+
+    void StreamWriter::endElement()
+    {
+        if (_open.empty())
+            throw Exception("endElement called without an open element");
+
+        if (_pending)
+        {
+            _pending = false;
+            put('/');
+            put('>');
+        }
+        else
+        {
+            if (_notMinify && !_open.back().hasText)
+                pad();
+
+            put('<');
+            put('/');
+            put(_open.back().name);
+            put('>');
+        }
+
+        if (_notMinify)
+            put('\n');
+
+        _open.pop_back();
+    }
+
+    void StreamWriter::endDocument()
+    {
+        if (!_open.empty())
+            throw Exception("unexpected end of document, '", _open.back().name, "' was not closed");
+
+        _finished = true;
+        flush();
+        _stream->flush();
+    }
+
+}  // namespace Rt2::Xml
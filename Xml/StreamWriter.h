@@ -0,0 +1,179 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Utils/String.h"
+#include "Xml/Writer.h"
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief Writes xml to a stream one element at a time, without a Node tree.
+     *
+     * Calls must be balanced; every startElement needs an endElement, attributes
+     * may only follow startElement and the document has a single root element.
+     * Anything else throws an exception. Output goes through a fixed size buffer
+     * and only the names of the open elements are kept, so the memory used does
+     * not depend on the size of the document.
+     *
+     * The output matches Writer for the same elements, as long as the text of an
+     * element is written before its children. The one exception is a root with
+     * no text or children in indented output, which Writer prefixes with a space
+     * and this does not, since the start tag is written before its content is known.
+     *
+     * \code{.cpp}
+     * Xml::StreamWriter out(std::cout, Xml::Indent2);
+     * out.startElement("rows");
+     * while (cursor.next())
+     * {
+     *     out.startElement("row");
+     *     out.attribute("id", cursor.id());
+     *     out.text(cursor.value());
+     *     out.endElement();
+     * }
+     * out.endElement();
+     * out.endDocument();
+     * \endcode
+     */
+    class StreamWriter
+    {
+    private:
+        struct Open
+        {
+            String name;
+            bool   hasText{false};
+        };
+
+        OStream*          _stream;
+        std::vector<char> _buffer;
+        size_t            _used{0};
+        std::vector<Open> _open;
+        int32_t           _indentBy{2};
+        bool              _notMinify{true};
+        bool              _pending{false};
+        bool              _hasRoot{false};
+        bool              _finished{false};
+
+        void put(char ch);
+
+        void put(std::string_view str);
+
+        void putEscaped(std::string_view str);
+
+        void pad();
+
+        void flush();
+
+        void closePending();
+
+    public:
+        /**
+         * \param output The stream to write to. It must outlive the writer.
+         * \param format A combination of the WriteFormat flags.
+         */
+        explicit StreamWriter(OStream& output, int format = Indent2);
+
+        /**
+         * \brief Passes any output that is still buffered on to the stream,
+         * so nothing is lost if endDocument was never reached. Stream errors
+         * are ignored here, call endDocument to have them reported.
+         */
+        ~StreamWriter();
+
+        void startElement(std::string_view name);
+
+        void attribute(std::string_view name, std::string_view value);
+
+        /**
+         * \brief Writes an attribute from any integer type, so that int64_t
+         * and size_t values do not have to pick between int and double.
+         */
+        template <typename T>
+            requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+        void attribute(std::string_view name, T value);
+
+        void attribute(std::string_view name, double value);
+
+        /**
+         * \brief Writes escaped text content into the current element.
+         */
+        void text(std::string_view value);
+
+        /**
+         * \brief Closes the most recently started element.
+         */
+        void endElement();
+
+        /**
+         * \brief Checks that every element has been closed and passes
+         * the remaining output on to the stream.
+         */
+        void endDocument();
+
+        /**
+         * \return The number of elements that have been started but not ended.
+         */
+        size_t depth() const;
+    };
+
+    inline void StreamWriter::put(const char ch)
+    {
+        if (_used >= _buffer.size())
+            flush();
+        _buffer[_used++] = ch;
+    }
+
+    inline void StreamWriter::put(std::string_view str)
+    {
+        while (!str.empty())
+        {
+            if (_used >= _buffer.size())
+                flush();
+
+            const size_t len = std::min(str.size(), _buffer.size() - _used);
+            memcpy(_buffer.data() + _used, str.data(), len);
+            _used += len;
+            str.remove_prefix(len);
+        }
+    }
+
+    template <typename T>
+        requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+    void StreamWriter::attribute(const std::string_view name, const T value)
+    {
+        char buf[24];
+
+        const auto [end, ec] = std::to_chars(buf, buf + sizeof buf, value);
+        attribute(name, std::string_view(buf, (size_t)(end - buf)));
+    }
+
+    inline size_t StreamWriter::depth() const
+    {
+        return _open.size();
+    }
+
+}  // namespace Rt2::Xml
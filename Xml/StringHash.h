@@ -0,0 +1,47 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <functional>
+#include <string_view>
+#include "Utils/String.h"
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief Transparent hash for String keyed containers.
+     *
+     * Allows unordered containers to be searched with a std::string_view
+     * or a string literal without first constructing a String.
+     */
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(const std::string_view str) const noexcept
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    using StringEqual = std::equal_to<>;
+
+}  // namespace Rt2::Xml
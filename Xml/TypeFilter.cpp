@@ -41,4 +41,15 @@ namespace Rt2
         }
     }
 
+    bool findTypeCode(const TypeFilterMap& map, const std::string_view name, int64_t& code)
+    {
+        if (const auto it = map.find(name);
+            it != map.end())
+        {
+            code = it->second;
+            return true;
+        }
+        return false;
+    }
+
 }  // namespace Rt2
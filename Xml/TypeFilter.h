@@ -21,7 +21,10 @@
 */
 #pragma once
 #include <cstdint>
+#include <string_view>
+#include <unordered_map>
 #include "Utils/String.h"
+#include "Xml/StringHash.h"
 
 namespace Rt2
 {
@@ -31,8 +34,17 @@ namespace Rt2
         int64_t     typeCode;
     };
 
-    using TypeFilterMap = std::unordered_map<String, int64_t>;
+    using TypeFilterMap = std::unordered_map<String, int64_t, Xml::StringHash, Xml::StringEqual>;
 
     extern void makeTypeFilter(TypeFilterMap& dest, const TypeFilter*, size_t size);
 
+    /**
+     * \brief Looks up the type code of the supplied name without allocating.
+     * \param map The filter to search.
+     * \param name The tag name to look up.
+     * \param code Receives the type code if the name is found.
+     * \return True if the name is in the filter.
+     */
+    extern bool findTypeCode(const TypeFilterMap& map, std::string_view name, int64_t& code);
+
 }  // namespace Rt2
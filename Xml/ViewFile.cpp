@@ -0,0 +1,160 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/ViewFile.h"
+#include <fstream>
+#include <iterator>
+#include "Utils/Exception.h"
+
+namespace Rt2::Xml
+{
+    constexpr std::string_view TextNodeName = "_text_node";
+
+    ViewFile::ViewFile(const TypeFilter* filter, const size_t filterSize)
+    {
+        applyFilter(filter, filterSize);
+    }
+
+    void ViewFile::applyFilter(const TypeFilter* filter, const size_t filterSize)
+    {
+        makeTypeFilter(_filter, filter, filterSize);
+    }
+
+    void ViewFile::clear()
+    {
+        _nodes.clear();
+        _attributes.clear();
+        _decoded.clear();
+    }
+
+    void ViewFile::read(String&& buffer)
+    {
+        _buffer = std::move(buffer);
+        attach(_buffer);
+    }
+
+    void ViewFile::read(IStream& input)
+    {
+        String buffer;
+        buffer.assign(std::istreambuf_iterator<char>(input),
+                      std::istreambuf_iterator<char>());
+        read(std::move(buffer));
+    }
+
+    void ViewFile::load(const String& path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if (!input.is_open())
+            throw Exception("Failed to open the input file '", path, "'");
+        read(input);
+    }
+
+    void ViewFile::attach(const std::string_view buffer)
+    {
+        clear();
+        _data = buffer;
+
+        try
+        {
+            parse();
+        }
+        catch (Exception&)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    void ViewFile::parse()
+    {
+        BufferReader reader(_data, &_decoded);
+
+        int64_t textCode = -1;
+        bool    keepText = true;
+        if (!_filter.empty())
+            keepText = findTypeCode(_filter, TextNodeName, textCode);
+
+        ViewNode* cur = &_nodes.emplace_back();
+
+        ReadEvent ev;
+        while ((ev = reader.next()) != READ_EOF)
+        {
+            if (ev == READ_START_TAG)
+            {
+                int64_t code = -1;
+                if (!_filter.empty() && !findTypeCode(_filter, reader.name(), code))
+                {
+                    reader.skipElement();
+                    continue;
+                }
+
+                const ViewAttributeArray& attributes = reader.attributes();
+
+                ViewNode* node        = &_nodes.emplace_back();
+                node->_name           = reader.name();
+                node->_typeCode       = code;
+                node->_attributeFirst = (uint32_t)_attributes.size();
+                node->_attributeCount = (uint32_t)attributes.size();
+                _attributes.insert(_attributes.end(), attributes.begin(), attributes.end());
+
+                cur->addChild(node);
+                cur = node;
+            }
+            else if (ev == READ_END_TAG)
+                cur = cur->_parent;
+            else if (ev == READ_TEXT)
+            {
+                cur->_text = reader.text();
+                if (keepText)
+                {
+                    ViewNode* node  = &_nodes.emplace_back();
+                    node->_name     = TextNodeName;
+                    node->_text     = reader.text();
+                    node->_typeCode = textCode;
+                    cur->addChild(node);
+                }
+            }
+        }
+
+        // The attribute array is stable now,
+        // so the ranges can be resolved.
+        for (ViewNode& node : _nodes)
+            node._attributes = _attributes.data() + node._attributeFirst;
+    }
+
+    const ViewNode* ViewFile::tree() const
+    {
+        if (_nodes.empty())
+            throw Exception("invalid pointer");
+        return &_nodes.front();
+    }
+
+    const ViewNode* ViewFile::root(const std::string_view name) const
+    {
+        return tree()->firstChildOf(name);
+    }
+
+    const ViewNode* ViewFile::root(const int64_t code) const
+    {
+        return tree()->firstChildOf(code);
+    }
+
+}  // namespace Rt2::Xml
@@ -0,0 +1,130 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <deque>
+#include "Utils/String.h"
+#include "Xml/BufferReader.h"
+#include "Xml/TypeFilter.h"
+#include "Xml/ViewNode.h"
+
+namespace Rt2::Xml
+{
+    /**
+     * \brief Provides a read-only, zero-copy alternative to File.
+     *
+     * The whole input is kept in one buffer and every name, attribute and
+     * text of the resulting tree is a view into it. Only attribute values and
+     * text that contain entity references are stored separately. Nodes and attributes
+     * are allocated in blocks, so the cost of a read depends on the number of
+     * elements rather than the number of bytes.
+     *
+     * The tree follows the same layout as File; tree() returns a base node
+     * whose children are the document's top level elements, and content text is
+     * stored in both the element and a '_text_node' child.
+     *
+     * \code{.cpp}
+     * Xml::ViewFile file;
+     * file.read(std::move(buffer));
+     *
+     * const Xml::ViewNode* root = file.root("root");
+     * int32_t count = root->int32("count");
+     * \endcode
+     */
+    class ViewFile
+    {
+    private:
+        String               _buffer;
+        std::string_view     _data;
+        std::deque<String>   _decoded;
+        ViewAttributeArray   _attributes;
+        std::deque<ViewNode> _nodes;
+        TypeFilterMap        _filter;
+
+        void parse();
+
+        void clear();
+
+    public:
+        ViewFile() = default;
+
+        /**
+         * \brief Constructs the file with a node type filter.
+         * \param filter A constant array of tag-name to tag-id structures.
+         * \param filterSize The total size of the constant array.
+         */
+        ViewFile(const TypeFilter* filter, size_t filterSize);
+
+        ViewFile(const ViewFile&) = delete;
+
+        ViewFile& operator=(const ViewFile&) = delete;
+
+        /**
+         * \brief Applies a node type filter. Only affects subsequent reads.
+         */
+        void applyFilter(const TypeFilter* filter, size_t filterSize);
+
+        /**
+         * \brief Takes ownership of the supplied buffer and reads it.
+         */
+        void read(String&& buffer);
+
+        /**
+         * \brief Reads the whole stream into the owned buffer, then reads it.
+         */
+        void read(IStream& input);
+
+        /**
+         * \brief Reads the supplied file from disk.
+         */
+        void load(const String& path);
+
+        /**
+         * \brief Reads a buffer that this file does not own.
+         *
+         * This is meant for memory that is managed elsewhere, such as a
+         * mapped file. The memory must remain valid and unchanged for as
+         * long as this file or any of its nodes are in use.
+         */
+        void attach(std::string_view buffer);
+
+        /**
+         * \brief Provides access to the base of the node tree.
+         * Its children are the top level elements of the document.
+         */
+        const ViewNode* tree() const;
+
+        const ViewNode* root(std::string_view name) const;
+
+        const ViewNode* root(int64_t code) const;
+
+        /**
+         * \return The total number of nodes, including the base node.
+         */
+        size_t nodeCount() const;
+    };
+
+    inline size_t ViewFile::nodeCount() const
+    {
+        return _nodes.size();
+    }
+
+}  // namespace Rt2::Xml
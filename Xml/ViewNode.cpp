@@ -0,0 +1,119 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "Xml/ViewNode.h"
+#include "Xml/Number.h"
+
+namespace Rt2::Xml
+{
+    void ViewNode::addChild(ViewNode* child)
+    {
+        child->_parent = this;
+        if (_lastChild)
+            _lastChild->_next = child;
+        else
+            _firstChild = child;
+        _lastChild = child;
+        ++_size;
+    }
+
+    bool ViewNode::contains(const std::string_view attribute) const
+    {
+        for (const auto& [k, v] : attributes())
+        {
+            if (k == attribute)
+                return true;
+        }
+        return false;
+    }
+
+    std::string_view ViewNode::attribute(const std::string_view name,
+                                         const std::string_view def) const
+    {
+        for (const auto& [k, v] : attributes())
+        {
+            if (k == name)
+                return v;
+        }
+        return def;
+    }
+
+    int64_t ViewNode::int64(const std::string_view name, const int64_t def) const
+    {
+        return toNumber<int64_t>(attribute(name), def);
+    }
+
+    int32_t ViewNode::int32(const std::string_view name, const int32_t def) const
+    {
+        return (int32_t)toNumber<int64_t>(attribute(name), (int64_t)def);
+    }
+
+    float ViewNode::float32(const std::string_view name, const float def) const
+    {
+        return toNumber<float>(attribute(name), def);
+    }
+
+    double ViewNode::float64(const std::string_view name, const double def) const
+    {
+        return toNumber<double>(attribute(name), def);
+    }
+
+    const ViewNode* ViewNode::firstChildOf(const std::string_view tag) const
+    {
+        for (const ViewNode* child = _firstChild; child; child = child->_next)
+        {
+            if (child->isTypeOf(tag))
+                return child;
+        }
+        return nullptr;
+    }
+
+    const ViewNode* ViewNode::firstChildOf(const int64_t& tag) const
+    {
+        for (const ViewNode* child = _firstChild; child; child = child->_next)
+        {
+            if (child->isTypeOf(tag))
+                return child;
+        }
+        return nullptr;
+    }
+
+    const ViewNode* ViewNode::nextSiblingOf(const std::string_view tag) const
+    {
+        for (const ViewNode* nd = _next; nd; nd = nd->_next)
+        {
+            if (nd->isTypeOf(tag))
+                return nd;
+        }
+        return nullptr;
+    }
+
+    const ViewNode* ViewNode::nextSiblingOf(const int64_t& tag) const
+    {
+        for (const ViewNode* nd = _next; nd; nd = nd->_next)
+        {
+            if (nd->isTypeOf(tag))
+                return nd;
+        }
+        return nullptr;
+    }
+
+}  // namespace Rt2::Xml
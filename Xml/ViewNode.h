@@ -0,0 +1,292 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include "Xml/BufferReader.h"
+
+namespace Rt2::Xml
+{
+    class ViewFile;
+
+    /**
+     * \brief Provides a contiguous range of ViewAttribute
+     */
+    class ViewAttributeRange
+    {
+    private:
+        const ViewAttribute* _begin{nullptr};
+        const ViewAttribute* _end{nullptr};
+
+    public:
+        ViewAttributeRange() = default;
+
+        ViewAttributeRange(const ViewAttribute* begin, const ViewAttribute* end) :
+            _begin(begin),
+            _end(end)
+        {
+        }
+
+        const ViewAttribute* begin() const
+        {
+            return _begin;
+        }
+
+        const ViewAttribute* end() const
+        {
+            return _end;
+        }
+
+        size_t size() const
+        {
+            return (size_t)(_end - _begin);
+        }
+
+        bool empty() const
+        {
+            return _begin == _end;
+        }
+    };
+
+    /**
+     * \brief Is the read-only node type of a ViewFile.
+     *
+     * The name, attributes and text are views into the buffer that the
+     * owning ViewFile holds, so a ViewNode is only valid for the lifetime
+     * of the file that created it.
+     */
+    class ViewNode
+    {
+    private:
+        friend class ViewFile;
+
+        int64_t              _typeCode{-1};
+        ViewNode*            _parent{nullptr};
+        ViewNode*            _firstChild{nullptr};
+        ViewNode*            _lastChild{nullptr};
+        ViewNode*            _next{nullptr};
+        size_t               _size{0};
+        std::string_view     _name;
+        std::string_view     _text;
+        const ViewAttribute* _attributes{nullptr};
+        uint32_t             _attributeFirst{0};
+        uint32_t             _attributeCount{0};
+
+        void addChild(ViewNode* child);
+
+    public:
+        /**
+         * \brief Forward iterator over a linked list of sibling nodes.
+         */
+        class Iterator
+        {
+        private:
+            const ViewNode* _node{nullptr};
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = const ViewNode*;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const ViewNode**;
+            using reference         = const ViewNode*;
+
+            Iterator() = default;
+
+            explicit Iterator(const ViewNode* node) :
+                _node(node)
+            {
+            }
+
+            const ViewNode* operator*() const
+            {
+                return _node;
+            }
+
+            Iterator& operator++()
+            {
+                _node = _node->_next;
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                const Iterator cp = *this;
+                _node             = _node->_next;
+                return cp;
+            }
+
+            bool operator==(const Iterator& rhs) const
+            {
+                return _node == rhs._node;
+            }
+
+            bool operator!=(const Iterator& rhs) const
+            {
+                return _node != rhs._node;
+            }
+        };
+
+        class Range
+        {
+        private:
+            const ViewNode* _first;
+
+        public:
+            explicit Range(const ViewNode* first) :
+                _first(first)
+            {
+            }
+
+            Iterator begin() const
+            {
+                return Iterator(_first);
+            }
+
+            Iterator end() const
+            {
+                return Iterator();
+            }
+        };
+
+        ViewNode() = default;
+
+        std::string_view name() const;
+
+        std::string_view text() const;
+
+        int64_t type() const;
+
+        const ViewNode* parent() const;
+
+        const ViewNode* firstChild() const;
+
+        const ViewNode* nextSibling() const;
+
+        Range children() const;
+
+        size_t size() const;
+
+        ViewAttributeRange attributes() const;
+
+        bool contains(std::string_view attribute) const;
+
+        std::string_view attribute(std::string_view name, std::string_view def = {}) const;
+
+        int64_t int64(std::string_view name, int64_t def = -1) const;
+
+        int32_t int32(std::string_view name, int32_t def = -1) const;
+
+        float float32(std::string_view name, float def = 0.f) const;
+
+        double float64(std::string_view name, double def = 0.0) const;
+
+        const ViewNode* firstChildOf(std::string_view tag) const;
+
+        const ViewNode* firstChildOf(const int64_t& tag) const;
+
+        const ViewNode* nextSiblingOf(std::string_view tag) const;
+
+        const ViewNode* nextSiblingOf(const int64_t& tag) const;
+
+        bool isTypeOf(std::string_view tagName) const;
+
+        bool isTypeOf(int64_t type) const;
+
+        bool hasChildren() const;
+
+        bool hasText() const;
+
+        bool hasAttributes() const;
+    };
+
+    inline std::string_view ViewNode::name() const
+    {
+        return _name;
+    }
+
+    inline std::string_view ViewNode::text() const
+    {
+        return _text;
+    }
+
+    inline int64_t ViewNode::type() const
+    {
+        return _typeCode;
+    }
+
+    inline const ViewNode* ViewNode::parent() const
+    {
+        return _parent;
+    }
+
+    inline const ViewNode* ViewNode::firstChild() const
+    {
+        return _firstChild;
+    }
+
+    inline const ViewNode* ViewNode::nextSibling() const
+    {
+        return _next;
+    }
+
+    inline ViewNode::Range ViewNode::children() const
+    {
+        return Range(_firstChild);
+    }
+
+    inline size_t ViewNode::size() const
+    {
+        return _size;
+    }
+
+    inline ViewAttributeRange ViewNode::attributes() const
+    {
+        return {_attributes, _attributes + _attributeCount};
+    }
+
+    inline bool ViewNode::isTypeOf(const std::string_view tagName) const
+    {
+        return _name == tagName;
+    }
+
+    inline bool ViewNode::isTypeOf(const int64_t type) const
+    {
+        return _typeCode == type;
+    }
+
+    inline bool ViewNode::hasChildren() const
+    {
+        return _firstChild != nullptr;
+    }
+
+    inline bool ViewNode::hasText() const
+    {
+        return !_text.empty();
+    }
+
+    inline bool ViewNode::hasAttributes() const
+    {
+        return _attributeCount > 0;
+    }
+
+}  // namespace Rt2::Xml
@@ -20,15 +20,43 @@
 -------------------------------------------------------------------------------
 */
 #include "Xml/Writer.h"
-#include <iomanip>
+#include <fstream>
+#ifdef RT_OPEN_MP
+    #include <omp.h>
+#endif
 #include "Utils/Exception.h"
 #include "Utils/FileSystem.h"
 #include "Xml/Node.h"
+#include "Xml/SpecialChar.h"
 
 namespace Rt2::Xml
 {
     constexpr size_t Indent = 2;
 
+    constexpr std::string_view XmlHeader = "<?xml version=\"1.0\"?>\n";
+
+    // Indentation is copied out of this in one piece per line,
+    // or in a few pieces for anything deeper than its length.
+    constexpr std::string_view Spaces =
+        "                                                                "
+        "                                                                ";
+
+    struct Writer::Piece
+    {
+        enum Kind
+        {
+            Open,
+            Close,
+            Run,
+        };
+
+        Kind               kind;
+        const Node*        node;
+        const Node* const* first;
+        const Node* const* last;
+        int32_t            indent;
+    };
+
     Writer::Writer(const Node* root) :
         _root(root),
         _indentBy{Indent}
@@ -43,15 +71,16 @@ namespace Rt2::Xml
         if (_notMinify)
         {
             if (_indent > 0)
-                _out << std::setw((size_t)_indent) << ' ';
+                pad(_indent);
         }
 
-        _out << '<' << tag->name();
+        put('<');
+        put(tag->name());
         writeAttributes(tag);
-        _out << '>';
+        put('>');
 
         if (_notMinify && !tag->hasText())
-            _out << std::endl;
+            put('\n');
     }
 
     void Writer::closeTag(const Node* tag)
@@ -62,13 +91,16 @@ namespace Rt2::Xml
         if (_notMinify)
         {
             if (!tag->hasText() && (int)_indent > 0)
-                _out << std::setw(_indent) << ' ';
+                pad(_indent);
         }
 
-        _out << '<' << '/' << tag->name() << '>';
+        put('<');
+        put('/');
+        put(tag->name());
+        put('>');
 
         if (_notMinify)
-            _out << std::endl;
+            put('\n');
     }
 
     void Writer::inlineTag(const Node* tag)
@@ -77,17 +109,18 @@ namespace Rt2::Xml
             return;
 
         if (_notMinify)
-            _out << std::setw(_indent) << ' ';
+            pad(_indent);
 
-        _out << '<'
-             << tag->name();
+        put('<');
+        put(tag->name());
 
         writeAttributes(tag);
 
-        _out << '/' << '>';
+        put('/');
+        put('>');
 
         if (_notMinify)
-            _out << std::endl;
+            put('\n');
     }
 
     void Writer::writeAttributes(const Node* tag)
@@ -100,8 +133,12 @@ namespace Rt2::Xml
             const AttributeMap& attr = tag->attributes();
             for (const auto& [k, v] : attr)
             {
-                _out << ' ';
-                _out << k << '=' << '"' << v << '"';
+                put(' ');
+                put(k);
+                put('=');
+                put('"');
+                putEscaped(v);
+                put('"');
             }
         }
     }
@@ -112,7 +149,7 @@ namespace Rt2::Xml
             return;
 
         openTag(tag);
-        _out << tag->text();
+        putEscaped(tag->text());
 
         for (const Node* element : tag->children())
             writeTag(element);
@@ -135,16 +172,241 @@ namespace Rt2::Xml
         _indent -= _indentBy;
     }
 
-    void Writer::write(OStream& output)
+    void Writer::pad(const int32_t width)
+    {
+        // same as std::setw(width) << ' ', which
+        // always writes at least one character
+        size_t remaining = width > 1 ? (size_t)width : 1;
+        while (remaining > 0)
+        {
+            const size_t len = std::min(remaining, Spaces.size());
+            put(Spaces.substr(0, len));
+            remaining -= len;
+        }
+    }
+
+    void Writer::putEscaped(std::string_view str)
+    {
+        // clean spans are copied in one piece
+        size_t idx;
+        while ((idx = SpecialChar::findEscape(str)) < str.size())
+        {
+            put(str.substr(0, idx));
+            put(SpecialChar::entity(str[idx]));
+            str.remove_prefix(idx + 1);
+        }
+        put(str);
+    }
+
+    void Writer::flush()
+    {
+        // a caller owned buffer cannot be emptied
+        if (_external)
+            throw Exception("the output buffer is too small");
+
+        if (_used > 0)
+        {
+            if (_stream)
+                _stream->write(_data, (std::streamsize)_used);
+            else if (_string)
+                _string->append(_data, _used);
+        }
+        _written += _used;
+        _used = 0;
+    }
+
+    void Writer::render()
     {
+        _used    = 0;
+        _written = 0;
+
         if (_writeXml)
-            _out << "<?xml version=\"1.0\"?>" << std::endl;
+            put(XmlHeader);
 
         _indent = (_indentOffset - _indentBy);
         writeTag(_root);
+    }
+
+    void Writer::useBuffer()
+    {
+        _buffer.resize(WriteBufferSize);
+        _data     = _buffer.data();
+        _capacity = _buffer.size();
+        _external = false;
+    }
+
+    void Writer::write(OStream& output)
+    {
+        useBuffer();
+        _stream = &output;
+
+        render();
+
+        flush();
+        _stream = nullptr;
+    }
 
-        const String dest = _out.str();
-        output.write(dest.c_str(), (std::streamsize)dest.size());
+    size_t Writer::measure()
+    {
+        // renders as usual, but flush drops
+        // the buffer instead of writing it
+        useBuffer();
+        _stream = nullptr;
+
+        render();
+
+        flush();
+        return _written;
+    }
+
+    size_t Writer::writeTo(char* dest, const size_t size)
+    {
+        if (!dest && size > 0)
+            throw Exception("invalid output buffer");
+
+        _stream   = nullptr;
+        _data     = dest;
+        _capacity = size;
+        _external = true;
+
+        try
+        {
+            render();
+        }
+        catch (...)
+        {
+            _data     = nullptr;
+            _capacity = 0;
+            _external = false;
+            throw;
+        }
+
+        const size_t used = _used;
+
+        _data     = nullptr;
+        _capacity = 0;
+        _external = false;
+        _used     = 0;
+        return used;
+    }
+
+    void Writer::writePiece(const Piece& piece, String& dest)
+    {
+        useBuffer();
+        _stream  = nullptr;
+        _string  = &dest;
+        _used    = 0;
+        _written = 0;
+
+        // _indent is left as writeTag would have it for piece.indent
+        switch (piece.kind)
+        {
+        case Piece::Open:
+            _indent = piece.indent;
+            openTag(piece.node);
+            putEscaped(piece.node->text());
+            break;
+        case Piece::Close:
+            _indent = piece.indent;
+            closeTag(piece.node);
+            break;
+        case Piece::Run:
+            _indent = piece.indent - _indentBy;
+            for (const Node* const* it = piece.first; it != piece.last; ++it)
+                writeTag(*it);
+            break;
+        }
+
+        flush();
+        _string = nullptr;
+    }
+
+    void Writer::writeParallel(OStream& output, const int threads)
+    {
+#ifdef RT_OPEN_MP
+        const int count = threads > 0 ? threads : omp_get_max_threads();
+        if (!_root || count <= 1)
+        {
+            write(output);
+            return;
+        }
+
+        const size_t target = (size_t)count * ParallelUnitsPerThread;
+
+        // Runs are split in half, and a run of one node with children is
+        // replaced by its open tag, a run of its children and its close tag.
+        std::vector<Piece> pieces, next;
+        pieces.push_back({Piece::Run, nullptr, &_root, &_root + 1, _indentOffset});
+
+        size_t runs  = 1;
+        bool   split = true;
+        while (split && runs < target)
+        {
+            split = false;
+            runs  = 0;
+            next.clear();
+            for (const Piece& piece : pieces)
+            {
+                if (piece.kind != Piece::Run)
+                {
+                    next.push_back(piece);
+                    continue;
+                }
+
+                const size_t len = (size_t)(piece.last - piece.first);
+                if (len > 1)
+                {
+                    const Node* const* mid = piece.first + len / 2;
+                    next.push_back({Piece::Run, nullptr, piece.first, mid, piece.indent});
+                    next.push_back({Piece::Run, nullptr, mid, piece.last, piece.indent});
+                    runs += 2;
+                    split = true;
+                    continue;
+                }
+
+                const Node* node = *piece.first;
+                ++runs;
+                if (!node || !node->hasChildren())
+                {
+                    next.push_back(piece);
+                    continue;
+                }
+
+                const NodeArray& children = node->children();
+                next.push_back({Piece::Open, node, nullptr, nullptr, piece.indent});
+                next.push_back({Piece::Run,
+                                nullptr,
+                                children.data(),
+                                children.data() + children.size(),
+                                piece.indent + _indentBy});
+                next.push_back({Piece::Close, node, nullptr, nullptr, piece.indent});
+                split = true;
+            }
+            pieces.swap(next);
+        }
+
+        std::vector<String> rendered(pieces.size());
+
+        const int total = (int)pieces.size();
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(count)
+        for (int i = 0; i < total; ++i)
+        {
+            Writer writer(_root);
+            writer._indentBy  = _indentBy;
+            writer._notMinify = _notMinify;
+            writer.writePiece(pieces[i], rendered[i]);
+        }
+
+        if (_writeXml)
+            output.write(XmlHeader.data(), (std::streamsize)XmlHeader.size());
+
+        for (const String& str : rendered)
+            output.write(str.data(), (std::streamsize)str.size());
+#else
+        (void)threads;
+        write(output);
+#endif
     }
 
     void Writer::write(const String& path)
@@ -162,9 +424,28 @@ namespace Rt2::Xml
                           const I32   indent,
                           const I32   offset)
     {
-        OutputStringStream oss;
-        toStream(oss, root, minify, indent, offset);
-        dest = oss.str();
+        Writer writer(root);
+        writer.setMinify(minify);
+        writer.setShowXmlHeader(false);
+        writer.setIndent(indent);
+        writer.setIndentOffset(offset);
+
+        // sized once, then rendered in place
+        dest.resize(writer.measure());
+        writer.writeTo(dest.data(), dest.size());
+    }
+
+    size_t Writer::measure(const Node* root,
+                           const bool  minify,
+                           const I32   indent,
+                           const I32   offset)
+    {
+        Writer writer(root);
+        writer.setMinify(minify);
+        writer.setShowXmlHeader(false);
+        writer.setIndent(indent);
+        writer.setIndentOffset(offset);
+        return writer.measure();
     }
 
     void Writer::toStream(OStream&    dest,
@@ -20,6 +20,10 @@
 -------------------------------------------------------------------------------
 */
 #pragma once
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <vector>
 #include "Utils/Definitions.h"
 #include "Utils/String.h"
 
@@ -34,21 +38,62 @@ namespace Rt2::Xml
         Indent4 = 0x04,
     };
 
+    /**
+     * \brief The size of the buffer the Writer renders into
+     * before it passes the output on to the stream.
+     */
+    constexpr size_t WriteBufferSize = 0x10000;
+
     /**
      * \brief Is a utility class that is used to write the xml
      * text structure to the supplied stream from the
      * supplied root node.
+     *
+     * Output is collected in a fixed size buffer that is written to the
+     * stream whenever it fills up, so the memory used does not depend on
+     * the size of the document.
+     *
+     * measure renders the document without keeping it and returns its exact
+     * size, which lets writeTo render into a caller owned buffer in one pass.
+     *
+     * writeParallel renders parts of the tree on separate threads and then
+     * writes them in order. Its output is the same as the output of write.
      */
     class Writer
     {
     private:
-        const Node*        _root;
-        OutputStringStream _out;
-        int32_t            _indentBy{2};
-        int32_t            _indentOffset{0};
-        int32_t            _indent{0};
-        bool               _writeXml{true};
-        bool               _notMinify{false};
+        struct Piece;
+
+        const Node*       _root;
+        std::vector<char> _buffer;
+        OStream*          _stream{nullptr};
+        String*           _string{nullptr};
+        char*             _data{nullptr};
+        size_t            _capacity{0};
+        size_t            _used{0};
+        size_t            _written{0};
+        bool              _external{false};
+        int32_t           _indentBy{2};
+        int32_t           _indentOffset{0};
+        int32_t           _indent{0};
+        bool              _writeXml{true};
+        bool              _notMinify{false};
+
+        void put(char ch);
+
+        void put(std::string_view str);
+
+        void putEscaped(std::string_view str);
+
+        void pad(int32_t width);
+
+        void flush();
+
+        void render();
+
+        void useBuffer();
+
+        void writePiece(const Piece& piece, String& dest);
 
         void openTag(const Node* tag);
 
@@ -75,6 +120,38 @@ namespace Rt2::Xml
         void write(OStream& output);
         void write(const String& path);
 
+        /**
+         * \brief Computes the number of bytes that write would produce
+         * with the current settings.
+         */
+        size_t measure();
+
+        /**
+         * \brief Renders the document directly into dest.
+         * \param dest The destination buffer.
+         * \param size The size of dest. It should be at least the value
+         * returned from measure, otherwise an exception is thrown.
+         * \return The number of bytes written to dest.
+         */
+        size_t writeTo(char* dest, size_t size);
+
+        /**
+         * \brief Writes the same output as write, but renders it on multiple threads.
+         *
+         * The top of the tree is split into runs of siblings until there are
+         * enough of them to share between the threads. Each run is rendered into
+         * its own string, so the whole document is held in memory before it is
+         * passed on to the stream. Without OpenMP this is the same as write.
+         * \param output The destination stream.
+         * \param threads The number of threads to use, or 0 for the default.
+         */
+        void writeParallel(OStream& output, int threads = 0);
+
+        static size_t measure(const Node* root,
+                              bool        minify = true,
+                              I32         indent = 4,
+                              I32         offset = 0);
+
         static void toString(String&     dest,
                              const Node* root,
                              bool        minify = true,
@@ -88,6 +165,27 @@ namespace Rt2::Xml
                              I32         offset = 0);
     };
 
+    inline void Writer::put(const char ch)
+    {
+        if (_used >= _capacity)
+            flush();
+        _data[_used++] = ch;
+    }
+
+    inline void Writer::put(std::string_view str)
+    {
+        while (!str.empty())
+        {
+            if (_used >= _capacity)
+                flush();
+
+            const size_t len = std::min(str.size(), _capacity - _used);
+            memcpy(_data + _used, str.data(), len);
+            _used += len;
+            str.remove_prefix(len);
+        }
+    }
+
     inline void Writer::setIndent(const int indent)
     {
         _indentBy = Clamp(indent, 1, 16);